@@ -310,8 +310,10 @@ int main(int argc, char **argv) {
     constexpr int MAX_PHYSICS_OBJECTS = 1000 * 10;
     ;
     std::shared_ptr<zo::PhysicsSystem2d> physics_system =
-        zo::PhysicsSystem2d::create(MAX_PHYSICS_OBJECTS, 4,
-                                    zo::BroadPhaseType::GRID);
+        zo::PhysicsSystem2d::create(
+            MAX_PHYSICS_OBJECTS, 4, zo::BroadPhaseType::GRID,
+            {.grid_size = 20.0f,
+             .world_bounds = {{0, 0}, {float(width), float(height)}}});
 
     std::vector<std::unique_ptr<GameObject>> game_objects;
 
@@ -330,6 +332,7 @@ int main(int argc, char **argv) {
     blaster_ball->physicsObject().setPosition({50, 50});
     blaster_ball->physicsObject().setMass(1000.0f);
     blaster_ball->physicsObject().setVelocity({0, 0});
+    blaster_ball->physicsObject().setBullet(true);
     game_objects.push_back(std::move(blaster_ball));
     game_obj_lifetime.push_back(30);
 
@@ -14,6 +14,7 @@
 #include <zero_physics/types.hpp>
 #include <glm/glm.hpp>
 #include <memory>
+#include <vector>
 
 namespace zo {
 
@@ -87,14 +88,63 @@ class LineCollider2d : virtual public Collider2d {
 class BoxCollider2d : virtual public Collider2d {
   public:
     virtual ~BoxCollider2d() = default;
-    virtual void  setWidth(float width) = 0;
-    virtual float width() const = 0;
-    virtual void  setHeight(float height) = 0;
-    virtual float height() const = 0;
+    virtual void      setWidth(float width) = 0;
+    virtual float     width() const = 0;
+    virtual void      setHeight(float height) = 0;
+    virtual float     height() const = 0;
+    virtual void      setCenter(const glm::vec2 &center) = 0;
+    virtual glm::vec2 center() const = 0;
+    virtual void      setAngle(float angle) = 0;
+    virtual float     angle() const = 0;
+    virtual void      setBox(const box_2d_t &box) = 0;
+    virtual box_2d_t  box() const = 0;
 
     ColliderType type() const override { return ColliderType::BOX; }
 
-    static std::unique_ptr<LineCollider2d>
+    static std::unique_ptr<BoxCollider2d>
+    create(CollisionSystem2d &collision_system);
+};
+
+/// @brief A static thick polyline, e.g., terrain.  The whole polyline is a
+/// single collider so the broad phase sees one entry however many segments
+/// it has.  Chains do not follow physics objects.
+class ChainCollider2d : virtual public Collider2d {
+  public:
+    virtual ~ChainCollider2d() = default;
+    virtual void setVertices(const std::vector<glm::vec2> &vertices) = 0;
+    virtual const std::vector<glm::vec2> &vertices() const = 0;
+    /// @brief Close the polyline, connecting the last vertex to the first
+    virtual void  setLoop(bool loop) = 0;
+    virtual bool  isLoop() const = 0;
+    virtual void  setThickness(float thickness) = 0;
+    virtual float thickness() const = 0;
+
+    ColliderType type() const override { return ColliderType::CHAIN; }
+
+    static std::unique_ptr<ChainCollider2d>
+    create(CollisionSystem2d &collision_system);
+};
+
+/// @brief A static thick heightfield, e.g., side scroller terrain.  Vertex i
+/// is at origin + (i * spacing, heights[i]).  Colliders find the columns
+/// under them by indexing so the cost does not depend on the heightfield
+/// size.  Heightfields do not follow physics objects.
+class HeightfieldCollider2d : virtual public Collider2d {
+  public:
+    virtual ~HeightfieldCollider2d() = default;
+    virtual void setHeights(const std::vector<float> &heights) = 0;
+    virtual const std::vector<float> &heights() const = 0;
+    virtual void      setOrigin(const glm::vec2 &origin) = 0;
+    virtual glm::vec2 origin() const = 0;
+    /// @brief Set the horizontal distance between heights (> 0)
+    virtual void  setSpacing(float spacing) = 0;
+    virtual float spacing() const = 0;
+    virtual void  setThickness(float thickness) = 0;
+    virtual float thickness() const = 0;
+
+    ColliderType type() const override { return ColliderType::HEIGHTFIELD; }
+
+    static std::unique_ptr<HeightfieldCollider2d>
     create(CollisionSystem2d &collision_system);
 };
 }; // namespace zo
@@ -21,8 +21,16 @@ public:
     
     /// @brief Create collision system implementation.
     /// @param max_colliders Maximum number of colliders.
+    /// @param broad_phase_type The broad phase collision scheme.
+    /// @param broad_phase_config Broad phase parameters (grid size, etc).
+    /// @param num_threads Number of threads used by the collision system.
+    /// 1 runs everything on the calling thread.
     /// @return 
-    static std::shared_ptr<CollisionSystem2d> create(size_t max_colliders, BroadPhaseType broad_phase_type = BroadPhaseType::NAIVE);
+    static std::shared_ptr<CollisionSystem2d>
+    create(size_t max_colliders,
+           BroadPhaseType broad_phase_type = BroadPhaseType::NAIVE,
+           const broad_phase_config_t &broad_phase_config = {},
+           size_t num_threads = 1);
 
     virtual ~CollisionSystem2d() = default;
 
@@ -30,7 +38,7 @@ public:
 
     /// @brief Create a collider of a specific type.
     /// The collider will be added into the collision system.
-    /// @tparam T The type of collider to create (CircleCollider2d,LineCollider2d, etc)
+    /// @tparam T The type of collider to create (CircleCollider2d,LineCollider2d,BoxCollider2d)
     /// @return Unique pointer to the collider
     template<typename T>
     std::unique_ptr<T> createCollider() {
@@ -38,8 +46,14 @@ public:
             return CircleCollider2d::create(*this);
         } else if constexpr (std::is_same_v<T, LineCollider2d>) {
             return LineCollider2d::create(*this);
+        } else if constexpr (std::is_same_v<T, BoxCollider2d>) {
+            return BoxCollider2d::create(*this);
+        } else if constexpr (std::is_same_v<T, ChainCollider2d>) {
+            return ChainCollider2d::create(*this);
+        } else if constexpr (std::is_same_v<T, HeightfieldCollider2d>) {
+            return HeightfieldCollider2d::create(*this);
         } else {
-            static_assert(std::is_same_v<T, CircleCollider2d> || std::is_same_v<T, LineCollider2d>, "Invalid collider type");
+            static_assert(std::is_same_v<T, CircleCollider2d> || std::is_same_v<T, LineCollider2d> || std::is_same_v<T, BoxCollider2d> || std::is_same_v<T, ChainCollider2d> || std::is_same_v<T, HeightfieldCollider2d>, "Invalid collider type");
         }
     }
 
@@ -54,6 +68,31 @@ public:
     /// @brief Run the collision system generating collision pairs.
     virtual void generateCollisionPairs() = 0;
 
+    /// @brief Get the number of overlapping collider pairs involving a sensor
+    /// found by the last generateCollisionPairs().  Sensor overlaps are only
+    /// reported, they are never resolved.
+    /// @return size_t the number of sensor overlaps
+    virtual size_t numSensorOverlaps() const = 0;
+
+    /// @brief Check if two colliders, at least one of them a sensor,
+    /// overlapped in the last generateCollisionPairs().
+    /// @param a a collider
+    /// @param b the other collider
+    /// @return true if the colliders overlapped
+    virtual bool sensorOverlaps(const Collider2d &a,
+                                const Collider2d &b) const = 0;
+
+    /// @brief Switch the broad phase implementation.  The colliders are
+    /// moved to the new broad phase so the world does not need recreating.
+    /// @param broad_phase_type The broad phase collision scheme.  AUTO picks
+    /// the implementation from the sampled statistics.
+    virtual void setBroadPhaseType(BroadPhaseType broad_phase_type) = 0;
+
+    /// @brief Get the broad phase statistics, including the AUTO switch
+    /// thresholds and decisions.
+    /// @return const broad_phase_stats_t&
+    virtual const broad_phase_stats_t &broadPhaseStats() const = 0;
+
 
 
 };
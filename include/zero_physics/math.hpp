@@ -47,6 +47,94 @@ bool circleToThickLineSegment(const circle_2d_t             &c,
 bool circleToCircle(const circle_2d_t &c1, const circle_2d_t &c2,
                     contact_2d_t &contact);
 
+/// @brief overlap test of two circles without computing contact information
+/// @param c1 circle 1
+/// @param c2 circle 2
+/// @return true if the circles overlap, false otherwise
+bool circleOverlapsCircle(const circle_2d_t &c1, const circle_2d_t &c2);
+
+/// @brief overlap test of a circle and a thick line segment without computing
+/// contact information
+/// @param c circle
+/// @param ls thick line segment
+/// @return true if they overlap, false otherwise
+bool circleOverlapsThickLineSegment(const circle_2d_t             &c,
+                                    const thick_line_segment_2d_t &ls);
+
+/// @brief collide thick line segment with thick line segment
+/// @param ls1 thick line segment 1
+/// @param ls2 thick line segment 2
+/// @param contact contact information if collision.  The normal points
+/// from ls1 to ls2.
+/// @return true if collision, false otherwise
+bool thickLineSegmentToThickLineSegment(const thick_line_segment_2d_t &ls1,
+                                        const thick_line_segment_2d_t &ls2,
+                                        contact_2d_t                  &contact);
+
+/// @brief overlap test of two thick line segments without computing contact
+/// information
+/// @param ls1 thick line segment 1
+/// @param ls2 thick line segment 2
+/// @return true if they overlap, false otherwise
+bool thickLineSegmentOverlapsThickLineSegment(
+    const thick_line_segment_2d_t &ls1, const thick_line_segment_2d_t &ls2);
+
+/// @brief axis aligned bounding box of an oriented box
+/// @param b box
+/// @return the bounding box
+aabb_2d_t boxAabb(const box_2d_t &b);
+
+/// @brief collide circle with oriented box
+/// @param c circle
+/// @param b box
+/// @param contact contact information if collision.  The normal points
+/// from the circle to the box.
+/// @return true if collision, false otherwise
+bool circleToBox(const circle_2d_t &c, const box_2d_t &b,
+                 contact_2d_t &contact);
+
+/// @brief collide thick line segment with oriented box using the separating
+/// axis test (box axes and the line normal)
+/// @param ls thick line segment
+/// @param b box
+/// @param contact contact information if collision.  The normal points
+/// from the line to the box.
+/// @return true if collision, false otherwise
+bool thickLineSegmentToBox(const thick_line_segment_2d_t &ls,
+                           const box_2d_t &b, contact_2d_t &contact);
+
+/// @brief collide two oriented boxes using the separating axis test
+/// @param b1 box 1
+/// @param b2 box 2
+/// @param contact contact information if collision.  The normal points
+/// from b1 to b2 and the point is the deepest point of b2.
+/// @return true if collision, false otherwise
+bool boxToBox(const box_2d_t &b1, const box_2d_t &b2, contact_2d_t &contact);
+
+/// @brief time of impact of two moving circles
+/// @param c1 circle 1 at the start of the step
+/// @param d1 displacement of circle 1 over the step
+/// @param c2 circle 2 at the start of the step
+/// @param d2 displacement of circle 2 over the step
+/// @param toi fraction [0, 1] of the step when the circles first touch. 0 if
+/// they already overlap at the start.
+/// @return true if the circles touch during the step, false otherwise
+bool timeOfImpactCircleToCircle(const circle_2d_t &c1, const glm::vec2 &d1,
+                                const circle_2d_t &c2, const glm::vec2 &d2,
+                                float &toi);
+
+/// @brief time of impact of a moving circle and a thick line segment
+/// @param c circle at the start of the step
+/// @param d displacement of the circle over the step
+/// @param ls thick line segment
+/// @param toi fraction [0, 1] of the step when they first touch. 0 if they
+/// already overlap at the start.
+/// @return true if they touch during the step, false otherwise
+bool timeOfImpactCircleToThickLineSegment(const circle_2d_t             &c,
+                                          const glm::vec2               &d,
+                                          const thick_line_segment_2d_t &ls,
+                                          float                         &toi);
+
 } // namespace zo
 
 #endif // __zoPhysicsMath_h__
\ No newline at end of file
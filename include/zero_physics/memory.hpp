@@ -295,8 +295,8 @@ template <typename T> class ComponentStore {
     // STL iterator support
     std::vector<T>::iterator begin() { return _components.begin(); }
     std::vector<T>::iterator end() { return _components.end(); }
-    std::vector<T>::iterator begin() const { return _components.begin(); }
-    std::vector<T>::iterator end() const { return _components.end(); }
+    std::vector<T>::const_iterator begin() const { return _components.begin(); }
+    std::vector<T>::const_iterator end() const { return _components.end(); }
 
 
     // accessors to the underlying data
@@ -76,6 +76,17 @@ class PhysicsObject2d {
     /// @return bool true if the physics object is static
     virtual bool                isStatic() const = 0;
 
+    /// @brief Set the physics object to be a bullet.  Bullets always use
+    /// continuous collision detection so they cannot tunnel through thin
+    /// colliders, however fast they move.  Other objects only do when they
+    /// move faster than broad_phase_config_t::swept_aabb_threshold.
+    /// @param is_bullet true if the physics object is a bullet
+    virtual void                setBullet(bool is_bullet) = 0;
+
+    /// @brief Check if the physics object is a bullet.
+    /// @return bool true if the physics object is a bullet
+    virtual bool                isBullet() const = 0;
+
     /// @brief Add a collider to the physics object.
     /// @param hndl The handle to the collider to add.
     /// @param vertex The vertex on the collider that this physics object controls. 
@@ -26,10 +26,16 @@ class PhysicsSystem2d {
     /// @brief create a physics system
     /// @param max_num_objects maximum number of physics objects
     /// @param iterations number of iterations to perform per update time step
+    /// @param broad_phase_type the broad phase collision scheme
+    /// @param broad_phase_config broad phase parameters (grid size, etc)
+    /// @param num_threads number of worker threads (including the calling
+    /// thread). 1 runs single threaded.
     /// @return the physics system
     static std::shared_ptr<PhysicsSystem2d>
     create(size_t max_num_objects = 1024, int iterations = 1,
-           BroadPhaseType broad_phase_type = BroadPhaseType::NAIVE);
+           BroadPhaseType              broad_phase_type = BroadPhaseType::NAIVE,
+           const broad_phase_config_t &broad_phase_config = {},
+           size_t                      num_threads = 1);
 
     /// @brief  Update the physics system.
     /// @param dt The time step to update the physics system by.
@@ -81,6 +87,43 @@ class PhysicsSystem2d {
     /// @return true if the handle is valid
     virtual bool isPhysicsHandleValid(phy_obj_handle_2d_t hndl) const = 0;
 
+    /// @brief Enable sub-stepping.  Without sub-stepping an update
+    /// integrates all its iterations and then detects and resolves the
+    /// collisions once.  With sub-stepping every iteration is a sub-step
+    /// that detects and resolves its collisions.  The broad phase only runs
+    /// in the first sub-step, with the collider aabbs inflated by the motion
+    /// of the remaining sub-steps; the others only repeat the narrow phase.
+    /// @param sub_stepping true to enable sub-stepping
+    virtual void setSubStepping(bool sub_stepping) = 0;
+
+    /// @brief Check if sub-stepping is enabled
+    /// @return true if sub-stepping is enabled
+    virtual bool subStepping() const = 0;
+
+    /// @brief Set the contact solver.  SEQUENTIAL resolves the contacts in
+    /// collision pair order.  GRAPH_COLORED colors the contacts so no two
+    /// contacts of a color share a dynamic object (static objects are not
+    /// shared) and resolves the contacts of a color in parallel on the
+    /// worker threads.  The result does not depend on the number of
+    /// threads.
+    /// @param type the contact solver type
+    virtual void setContactSolverType(ContactSolverType type) = 0;
+
+    /// @brief Get the contact solver type
+    /// @return the contact solver type
+    virtual ContactSolverType contactSolverType() const = 0;
+
+    /// @brief Set the contact solver iterations and penetration recovery.
+    /// Throws std::runtime_error if velocity_iterations < 1 or
+    /// position_iterations < 0.
+    /// @param config the contact solver parameters
+    virtual void
+    setContactSolverConfig(const contact_solver_config_t &config) = 0;
+
+    /// @brief Get the contact solver parameters
+    /// @return the contact solver parameters
+    virtual const contact_solver_config_t &contactSolverConfig() const = 0;
+
     /// @brief Get the collision system
     /// @return
     virtual CollisionSystem2d &collisionSystem() = 0;
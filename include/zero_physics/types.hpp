@@ -27,10 +27,43 @@ struct CollisionPair;
 using collider_pair_t = CollisionPair;
 
 // collider enum
-enum class ColliderType { CIRCLE = 1, LINE = 2, BOX = 3, MAX = 4 };
+enum class ColliderType {
+    CIRCLE = 1,
+    LINE = 2,
+    BOX = 3,
+    CHAIN = 4,
+    HEIGHTFIELD = 5,
+    MAX = 6
+};
 
 // broad phase detector
-enum class BroadPhaseType { NAIVE = 1, GRID = 2, SWEEP_PRUNE = 3 };
+enum class BroadPhaseType {
+    NAIVE = 1,
+    GRID = 2,
+    SWEEP_PRUNE = 3,
+    DYNAMIC_TREE = 4,
+    VERLET_LIST = 5,
+    BRUTE_FORCE = 6,
+    HIERARCHICAL_GRID = 7,
+    LINEAR_BVH = 8,
+    AUTO = 9, // pick NAIVE, GRID or DYNAMIC_TREE at runtime
+    SPATIAL_HASH = 10
+};
+
+// contact solver of the physics system
+enum class ContactSolverType {
+    SEQUENTIAL = 1,   // resolve the contacts one after the other
+    GRAPH_COLORED = 2 // resolve batches of contacts without shared objects
+                      // in parallel
+};
+
+/// @brief Why the AUTO broad phase last switched implementation
+enum class BroadPhaseSwitchReason {
+    NONE = 0,
+    COLLIDER_COUNT = 1, // collider count crossed the naive threshold
+    SIZE_SPREAD = 2,    // collider sizes became mixed (or uniform again)
+    PAIR_RATIO = 3      // grid produced too many pairs per contact
+};
 
 struct line_segment_2d_t {
     glm::vec2 start;
@@ -53,6 +86,116 @@ struct circle_2d_t {
     float     radius;
 };
 
+/// @brief An oriented box
+struct box_2d_t {
+    glm::vec2 center;
+    glm::vec2 half_extents;
+    float     angle; // radians
+};
+
+/// @brief Switch thresholds of the AUTO broad phase
+struct broad_phase_auto_thresholds_t {
+    /// @brief number of frames between samples (and possible switches)
+    uint32_t sample_interval = 30;
+
+    /// @brief up to this many dynamic colliders the naive broad phase is used
+    uint32_t naive_max_colliders = 64;
+
+    /// @brief largest to smallest collider extent ratio above which the
+    /// dynamic tree is used instead of the grid
+    float size_spread = 8.0f;
+
+    /// @brief broad phase pairs per contact above which the grid is
+    /// considered too coarse and the dynamic tree is used
+    float pair_ratio = 8.0f;
+
+    /// @brief fraction a sample has to fall back past a threshold before
+    /// switching back.  Keeps the broad phase from flip flopping.
+    float hysteresis = 0.25f;
+};
+
+/// @brief Broad phase creation parameters
+struct broad_phase_config_t {
+    /// @brief cell size of grid based broad phases (including the spatial
+    /// hash).  For the hierarchical grid this is the finest level, each
+    /// coarser level doubles it.  Must be greater than 0.
+    float grid_size = 50.0f;
+
+    /// @brief world bounds of grid based broad phases.  Colliders outside the
+    /// bounds are clamped into the border cells.  If the bounds are empty
+    /// (mn > mx) they are fit to the colliders every frame.
+    aabb_2d_t world_bounds = {glm::vec2(1.0f), glm::vec2(-1.0f)};
+
+    /// @brief skin distance of the verlet list broad phase.  Neighbor lists
+    /// are rebuilt once a collider has moved more than half the skin.
+    float verlet_skin = 4.0f;
+
+    /// @brief circles moving more than this fraction of their radius in a
+    /// step get an AABB swept from their previous position, so fast movers
+    /// are caught by thin walls.  Negative disables swept AABBs.
+    float swept_aabb_threshold = 1.0f;
+
+    /// @brief thresholds of the AUTO broad phase
+    broad_phase_auto_thresholds_t auto_thresholds = {};
+};
+
+/// @brief Contact solver parameters
+struct contact_solver_config_t {
+    /// @brief number of impulse passes over the contacts.  1 resolves every
+    /// contact with a single impulse, more iterations converge the contacts
+    /// of piles and stacks (projected Gauss-Seidel).
+    int velocity_iterations = 1;
+
+    /// @brief fraction of its impulse in the last step a contact starts
+    /// with if velocity_iterations > 1.  Lets the iterations of stacks build
+    /// on the last step instead of converging from scratch.  0 disables warm
+    /// starting.
+    float warm_starting = 1.0f;
+
+    /// @brief number of penetration recovery passes over the contacts.  0
+    /// leaves penetrating objects to the impulses.
+    int position_iterations = 0;
+
+    /// @brief fraction of the penetration removed per position iteration
+    float baumgarte = 0.2f;
+
+    /// @brief penetration that is not recovered so resting contacts stay
+    /// in contact
+    float linear_slop = 0.01f;
+};
+
+/// @brief Broad phase statistics.  Sampled every
+/// broad_phase_auto_thresholds_t::sample_interval frames.
+struct broad_phase_stats_t {
+    /// @brief the broad phase implementation in use
+    BroadPhaseType type = BroadPhaseType::NAIVE;
+
+    /// @brief true if the implementation is picked at runtime (AUTO)
+    bool is_auto = false;
+
+    /// @brief number of frames run
+    uint64_t frame = 0;
+
+    /// @brief sampled number of dynamic colliders
+    uint32_t num_colliders = 0;
+
+    /// @brief sampled largest to smallest collider extent ratio
+    float size_spread = 1.0f;
+
+    /// @brief sampled broad phase pairs per contact
+    float pair_ratio = 0.0f;
+
+    /// @brief number of times the AUTO broad phase switched implementation
+    uint32_t num_switches = 0;
+
+    /// @brief frame and reason of the last switch
+    uint64_t               last_switch_frame = 0;
+    BroadPhaseSwitchReason last_switch_reason = BroadPhaseSwitchReason::NONE;
+
+    /// @brief the AUTO switch thresholds
+    broad_phase_auto_thresholds_t thresholds = {};
+};
+
 struct ray_2d_t {
     glm::vec2 origin;
     glm::vec2 direction;
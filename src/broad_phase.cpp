@@ -1,10 +1,86 @@
 #include "broad_phase.hpp"
 #include "collision_system_2d_impl.hpp"
-#include <unordered_map>
-#include <unordered_set>
 #include <iostream>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <bit>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
 
 namespace zo {
+
+namespace {
+inline bool aabbOverlap(const aabb_2d_t &a, const aabb_2d_t &b) {
+    return a.mn.x <= b.mx.x && b.mn.x <= a.mx.x && a.mn.y <= b.mx.y &&
+           b.mn.y <= a.mx.y;
+}
+
+inline bool aabbContains(const aabb_2d_t &outer, const aabb_2d_t &inner) {
+    return outer.mn.x <= inner.mn.x && outer.mn.y <= inner.mn.y &&
+           inner.mx.x <= outer.mx.x && inner.mx.y <= outer.mx.y;
+}
+
+inline aabb_2d_t aabbUnion(const aabb_2d_t &a, const aabb_2d_t &b) {
+    return {glm::min(a.mn, b.mn), glm::max(a.mx, b.mx)};
+}
+
+inline float aabbPerimeter(const aabb_2d_t &a) {
+    const glm::vec2 d = a.mx - a.mn;
+    return 2.0f * (d.x + d.y);
+}
+} // namespace
+
+void StaticColliderTree::build(
+    const CollisionSystem2dImpl           &collision_system,
+    const ComponentStore<ColliderHandle> &colliders) {
+    _items.clear();
+    _nodes.clear();
+    for (const ColliderHandle &hndl : colliders) {
+        _items.push_back(
+            {hndl, collision_system.getBaseColliderData(hndl).aabb});
+    }
+    if (_items.empty() == false) {
+        buildNode(0, uint32_t(_items.size()));
+    }
+}
+
+uint32_t StaticColliderTree::buildNode(uint32_t begin, uint32_t end) {
+    const uint32_t node = uint32_t(_nodes.size());
+    _nodes.emplace_back();
+
+    aabb_2d_t bounds = _items[begin].aabb;
+    for (uint32_t i = begin + 1; i < end; i++) {
+        bounds = aabbUnion(bounds, _items[i].aabb);
+    }
+    _nodes[node].aabb = bounds;
+
+    if (end - begin <= LEAF_SIZE) {
+        _nodes[node].first = begin;
+        _nodes[node].count = end - begin;
+        return node;
+    }
+
+    // split at the median center along the longest axis
+    const glm::vec2 extent = bounds.mx - bounds.mn;
+    const int       axis = extent.x >= extent.y ? 0 : 1;
+    const uint32_t  mid = begin + (end - begin) / 2;
+    std::nth_element(_items.begin() + begin, _items.begin() + mid,
+                     _items.begin() + end,
+                     [axis](const Item &a, const Item &b) {
+                         return a.aabb.mn[axis] + a.aabb.mx[axis] <
+                                b.aabb.mn[axis] + b.aabb.mx[axis];
+                     });
+    buildNode(begin, mid);
+    const uint32_t right = buildNode(mid, end);
+    _nodes[node].right = right;
+    return node;
+}
+
 void NaiveBroadPhase::generateCollisionPairs() {
     const ComponentStore<collider_handle_2d_t> &colliders =
         _col_sys.colliders();
@@ -17,6 +93,9 @@ void NaiveBroadPhase::generateCollisionPairs() {
             if (c1.handle == c2.handle) {
                 continue;
             }
+            if (_col_sys.shouldCollide(c1, c2) == false) {
+                continue;
+            }
             CollisionPair pair;
             pair.a = c1;
             pair.b = c2;
@@ -25,59 +104,1183 @@ void NaiveBroadPhase::generateCollisionPairs() {
     }
 }
 
+int GridBroadPhase::cellCoord(float p, int limit, bool round_up) {
+    // clamp before converting, out of range floats don't convert to int
+    p = round_up ? std::ceil(p) : std::floor(p);
+    if ((p > 0) == false) {
+        return round_up ? 1 : 0; // also NaN
+    }
+    return p < float(limit) ? int(p) : limit;
+}
+
 void GridBroadPhase::generateCollisionPairs() {
-    std::unordered_map<std::pair<int, int>, std::vector<ColliderHandle>,
-                       GridBroadPhase::pair_hash>
-        grid_map;
+    const ComponentStore<ColliderHandle> &colliders = _col_sys.colliders();
+    const size_t                          num_colliders = colliders.size();
+    _collision_pairs.clear();
+    if (num_colliders < 2) {
+        return;
+    }
+
+    // gather the bounds, fitting the world bounds to them if not given
+    _aabbs.resize(num_colliders);
+    aabb_2d_t bounds = _world_bounds;
+    const bool fit_bounds = bounds.mn.x > bounds.mx.x ||
+                            bounds.mn.y > bounds.mx.y;
+    if (fit_bounds) {
+        bounds = _col_sys.getBaseColliderData(colliders.at(0)).aabb;
+    }
+    for (size_t i = 0; i < num_colliders; i++) {
+        _aabbs[i] = _col_sys.getBaseColliderData(colliders.at(i)).aabb;
+        if (fit_bounds) {
+            bounds = aabbUnion(bounds, _aabbs[i]);
+        }
+    }
+
+    // grid dimensions
+    const glm::vec2 extent = bounds.mx - bounds.mn;
+    const int       num_x = cellCoord(extent.x / _grid_size, MAX_CELLS_PER_AXIS,
+                                      true);
+    const int       num_y = cellCoord(extent.y / _grid_size, MAX_CELLS_PER_AXIS,
+                                      true);
+    const glm::vec2 inv_cell_size = {
+        1.0f / std::max(_grid_size, extent.x / num_x),
+        1.0f / std::max(_grid_size, extent.y / num_y)};
+    const size_t num_cells = size_t(num_x) * size_t(num_y);
+
+    // count the colliders in each cell.  Counts are stored one past the cell
+    // so the prefix sum below turns them into start offsets.
+    _cell_ranges.resize(num_colliders);
+    _cell_starts.assign(num_cells + 1, 0);
+    for (size_t i = 0; i < num_colliders; i++) {
+        const glm::vec2 mn = (_aabbs[i].mn - bounds.mn) * inv_cell_size;
+        const glm::vec2 mx = (_aabbs[i].mx - bounds.mn) * inv_cell_size;
+        CellRange      &range = _cell_ranges[i];
+        range.mn_x = cellCoord(mn.x, num_x - 1);
+        range.mn_y = cellCoord(mn.y, num_y - 1);
+        range.mx_x = cellCoord(mx.x, num_x - 1);
+        range.mx_y = cellCoord(mx.y, num_y - 1);
+        for (int y = range.mn_y; y <= range.mx_y; y++) {
+            for (int x = range.mn_x; x <= range.mx_x; x++) {
+                _cell_starts[size_t(y) * num_x + x + 1]++;
+            }
+        }
+    }
 
+    // prefix sum the counts into cell start offsets
+    for (size_t c = 1; c <= num_cells; c++) {
+        _cell_starts[c] += _cell_starts[c - 1];
+    }
+
+    // scatter the collider indices into the cells.  The start offsets are
+    // used as write cursors and are restored afterwards.
+    _cell_entries.resize(_cell_starts[num_cells]);
+    for (size_t i = 0; i < num_colliders; i++) {
+        const CellRange &range = _cell_ranges[i];
+        for (int y = range.mn_y; y <= range.mx_y; y++) {
+            for (int x = range.mn_x; x <= range.mx_x; x++) {
+                _cell_entries[_cell_starts[size_t(y) * num_x + x]++] =
+                    uint32_t(i);
+            }
+        }
+    }
+    for (size_t c = num_cells; c > 0; c--) {
+        _cell_starts[c] = _cell_starts[c - 1];
+    }
+    _cell_starts[0] = 0;
+
+    // generate pairs within each cell, in stripes of rows per thread
+    _num_x = num_x;
+    _num_y = num_y;
+    WorkerPool &pool = _col_sys.workerPool();
+    if (pool.numThreads() == 1) {
+        generateRowPairs(0, num_y, _collision_pairs);
+        return;
+    }
+    _thread_pairs.resize(pool.numThreads());
+    for (std::vector<CollisionPair> &pairs : _thread_pairs) {
+        pairs.clear();
+    }
+    pool.parallelFor(size_t(num_y), [this](size_t begin, size_t end,
+                                           size_t worker) {
+        generateRowPairs(int(begin), int(end), _thread_pairs[worker]);
+    });
+
+    // merge in worker (i.e., row) order so the result is deterministic
+    for (const std::vector<CollisionPair> &pairs : _thread_pairs) {
+        _collision_pairs.insert(_collision_pairs.end(), pairs.begin(),
+                                pairs.end());
+    }
+}
+
+void GridBroadPhase::generateRowPairs(int row_begin, int row_end,
+                                      std::vector<CollisionPair> &pairs) const {
     const ComponentStore<ColliderHandle> &colliders = _col_sys.colliders();
+    for (int y = row_begin; y < row_end; y++) {
+        for (int x = 0; x < _num_x; x++) {
+            const size_t   cell = size_t(y) * _num_x + x;
+            const uint32_t begin = _cell_starts[cell];
+            const uint32_t end = _cell_starts[cell + 1];
+            for (uint32_t i = begin; i < end; i++) {
+                const uint32_t   c1 = _cell_entries[i];
+                const CellRange &r1 = _cell_ranges[c1];
+                for (uint32_t p = i + 1; p < end; p++) {
+                    const uint32_t   c2 = _cell_entries[p];
+                    const CellRange &r2 = _cell_ranges[c2];
+
+                    // only the cell owning the pair reports it
+                    if (std::max(r1.mn_x, r2.mn_x) != x ||
+                        std::max(r1.mn_y, r2.mn_y) != y) {
+                        continue;
+                    }
+                    if (aabbOverlap(_aabbs[c1], _aabbs[c2]) == false) {
+                        continue;
+                    }
+                    if (_col_sys.shouldCollide(colliders.at(c1),
+                                               colliders.at(c2)) == false) {
+                        continue;
+                    }
+                    CollisionPair pair;
+                    pair.a = colliders.at(c1);
+                    pair.b = colliders.at(c2);
+                    pairs.push_back(pair);
+                }
+            }
+        }
+    }
+}
+
+void SweepAndPruneBroadPhase::addCollider(const ColliderHandle &hndl) {
+    uint32_t proxy_idx;
+    if (_free_proxies.empty() == false) {
+        proxy_idx = _free_proxies.back();
+        _free_proxies.pop_back();
+    } else {
+        proxy_idx = uint32_t(_proxies.size());
+        _proxies.emplace_back();
+    }
+    Proxy &proxy = _proxies[proxy_idx];
+    proxy.hndl = hndl;
+    proxy.aabb = _col_sys.getBaseColliderData(hndl).aabb;
+    proxy.active_idx = INVALID_INDEX;
+    proxy.is_valid = true;
+    _proxy_map[hndl.handle] = proxy_idx;
+
+    // new end points are appended and moved into place by the next sort
+    _end_points.push_back({proxy.aabb.mn.x, proxy_idx, false});
+    _end_points.push_back({proxy.aabb.mx.x, proxy_idx, true});
+}
+
+void SweepAndPruneBroadPhase::removeCollider(const ColliderHandle &hndl) {
+    auto it = _proxy_map.find(hndl.handle);
+    if (it == _proxy_map.end()) {
+        return;
+    }
+    const uint32_t proxy_idx = it->second;
+    _proxy_map.erase(it);
+    _proxies[proxy_idx].is_valid = false;
+    _free_proxies.push_back(proxy_idx);
+
+    // removing keeps the remaining end points in sorted order
+    _end_points.erase(std::remove_if(_end_points.begin(), _end_points.end(),
+                                     [proxy_idx](const EndPoint &ep) {
+                                         return ep.proxy == proxy_idx;
+                                     }),
+                      _end_points.end());
+}
+
+void SweepAndPruneBroadPhase::generateCollisionPairs() {
     _collision_pairs.clear();
-    const float inv_grid_size = 1.0f / _grid_size;
-    for (int i = 0; i < colliders.size(); i++) {
-        const ColliderHandle &hndl = colliders.at(i);
-        const auto      &base_col_data = _col_sys.getBaseColliderData(hndl);
-        const aabb_2d_t &aabb = base_col_data.aabb;
 
+    // refresh the proxy bounds written by the physics system.  Inverted or
+    // NaN bounds are left out of the sweep; their end points are moved to
+    // the end so they cannot break the ordering of the others.
+    for (Proxy &proxy : _proxies) {
+        proxy.active_idx = INVALID_INDEX;
+        if (proxy.is_valid) {
+            proxy.aabb = _col_sys.getBaseColliderData(proxy.hndl).aabb;
+            proxy.is_swept = proxy.aabb.mn.x <= proxy.aabb.mx.x &&
+                             proxy.aabb.mn.y <= proxy.aabb.mx.y;
+        }
+    }
+    for (EndPoint &ep : _end_points) {
+        const Proxy &proxy = _proxies[ep.proxy];
+        if (proxy.is_swept == false) {
+            ep.value = std::numeric_limits<float>::max();
+            continue;
+        }
+        ep.value = ep.is_max ? proxy.aabb.mx.x : proxy.aabb.mn.x;
+    }
 
-        const glm::vec2 mn = aabb.mn * inv_grid_size;
-        const glm::vec2 mx = aabb.mx * inv_grid_size;
-        const int       mn_x = std::floor(mn.x);
-        const int       mn_y = std::floor(mn.y);
-        const int       mx_x = std::floor(mx.x);
-        const int       mx_y = std::floor(mx.y);
+    // insertion sort.  The end points are almost sorted from the last frame
+    // so this is close to linear.
+    for (size_t i = 1; i < _end_points.size(); i++) {
+        const EndPoint key = _end_points[i];
+        size_t         j = i;
+        while (j > 0 && key < _end_points[j - 1]) {
+            _end_points[j] = _end_points[j - 1];
+            j--;
+        }
+        _end_points[j] = key;
+    }
 
+    // sweep along x keeping a list of open intervals.  Every interval that
+    // opens while another is open overlaps it on x so only y is tested.
+    _active.clear();
+    for (const EndPoint &ep : _end_points) {
+        Proxy &proxy = _proxies[ep.proxy];
+        if (proxy.is_swept == false) {
+            continue;
+        }
+        if (ep.is_max) {
+            // swap remove from the active list
+            const uint32_t last = _active.back();
+            _active[proxy.active_idx] = last;
+            _proxies[last].active_idx = proxy.active_idx;
+            _active.pop_back();
+            proxy.active_idx = INVALID_INDEX;
+            continue;
+        }
 
-        for (int x = mn_x; x <= mx_x; x++) {
-            for (int y = mn_y; y <= mx_y; y++) {
-                const std::pair<int, int> grid_key{x, y};
-                grid_map[grid_key].emplace_back(hndl);
+        for (uint32_t other_idx : _active) {
+            const Proxy &other = _proxies[other_idx];
+            if (proxy.aabb.mn.y <= other.aabb.mx.y &&
+                other.aabb.mn.y <= proxy.aabb.mx.y &&
+                _col_sys.shouldCollide(other.hndl, proxy.hndl)) {
+                CollisionPair pair;
+                pair.a = other.hndl;
+                pair.b = proxy.hndl;
+                _collision_pairs.push_back(pair);
             }
         }
+        proxy.active_idx = uint32_t(_active.size());
+        _active.push_back(ep.proxy);
     }
+}
 
-    // generate collision pair set to avoid duplicates
-    std::unordered_set<CollisionPair, GridBroadPhase::collision_pair_hash> collision_pair_set;
-    CollisionPair pair;
-    for (const auto &[cell, colliders] : grid_map) {
-        for (int i = 0; i < colliders.size(); i++) {
-            const ColliderHandle &c1 = colliders[i];
-            for (int p = i + 1; p < colliders.size(); p++) {
-                const ColliderHandle &c2 = colliders[p];
-                // ignore self collision
-                if (c1.handle == c2.handle) {
-                    continue;
-                }                
-                pair.a = c1;
-                pair.b = c2;
-                collision_pair_set.insert(pair);
+int32_t DynamicTreeBroadPhase::allocateNode() {
+    if (_free_list == NULL_NODE) {
+        _nodes.emplace_back();
+        _nodes.back().height = 0;
+        return int32_t(_nodes.size() - 1);
+    }
+    const int32_t node = _free_list;
+    _free_list = _nodes[node].parent;
+    _nodes[node] = Node{};
+    _nodes[node].height = 0;
+    return node;
+}
+
+void DynamicTreeBroadPhase::freeNode(int32_t node) {
+    _nodes[node].parent = _free_list;
+    _nodes[node].height = -1;
+    _free_list = node;
+}
+
+void DynamicTreeBroadPhase::addCollider(const ColliderHandle &hndl) {
+    const int32_t leaf = allocateNode();
+    Node         &node = _nodes[leaf];
+    node.hndl = hndl;
+    node.tight_aabb = _col_sys.getBaseColliderData(hndl).aabb;
+    node.aabb = {node.tight_aabb.mn - glm::vec2(_fat_margin),
+                 node.tight_aabb.mx + glm::vec2(_fat_margin)};
+    node.leaf_idx = uint32_t(_leaves.size());
+    _leaves.push_back(leaf);
+    _leaf_map[hndl.handle] = leaf;
+    insertLeaf(leaf);
+}
+
+void DynamicTreeBroadPhase::removeCollider(const ColliderHandle &hndl) {
+    auto it = _leaf_map.find(hndl.handle);
+    if (it == _leaf_map.end()) {
+        return;
+    }
+    const int32_t leaf = it->second;
+    _leaf_map.erase(it);
+    removeLeaf(leaf);
 
+    // swap remove from the leaf list
+    const uint32_t leaf_idx = _nodes[leaf].leaf_idx;
+    _leaves[leaf_idx] = _leaves.back();
+    _nodes[_leaves[leaf_idx]].leaf_idx = leaf_idx;
+    _leaves.pop_back();
+
+    freeNode(leaf);
+}
+
+void DynamicTreeBroadPhase::insertLeaf(int32_t leaf) {
+    if (_root == NULL_NODE) {
+        _root = leaf;
+        _nodes[_root].parent = NULL_NODE;
+        return;
+    }
+
+    // find the best sibling using the surface area (perimeter) heuristic
+    const aabb_2d_t leaf_aabb = _nodes[leaf].aabb;
+    int32_t         index = _root;
+    while (_nodes[index].isLeaf() == false) {
+        const Node &node = _nodes[index];
+        const float area = aabbPerimeter(node.aabb);
+        const float combined_area =
+            aabbPerimeter(aabbUnion(node.aabb, leaf_aabb));
+
+        // cost of creating a new parent for this node and the new leaf
+        const float cost = 2.0f * combined_area;
+
+        // minimum cost of pushing the leaf further down the tree
+        const float inheritance_cost = 2.0f * (combined_area - area);
+
+        auto descend_cost = [&](int32_t child) {
+            const Node &c = _nodes[child];
+            const float union_area = aabbPerimeter(aabbUnion(leaf_aabb, c.aabb));
+            if (c.isLeaf()) {
+                return union_area + inheritance_cost;
             }
+            return union_area - aabbPerimeter(c.aabb) + inheritance_cost;
+        };
+        const float cost1 = descend_cost(node.child1);
+        const float cost2 = descend_cost(node.child2);
+
+        if (cost < cost1 && cost < cost2) {
+            break;
+        }
+        index = cost1 < cost2 ? node.child1 : node.child2;
+    }
+    const int32_t sibling = index;
+
+    // create a new parent.  NOTE: allocating may grow the node array so
+    // only hold on to indices across this call.
+    const int32_t old_parent = _nodes[sibling].parent;
+    const int32_t new_parent = allocateNode();
+    _nodes[new_parent].parent = old_parent;
+    _nodes[new_parent].aabb = aabbUnion(leaf_aabb, _nodes[sibling].aabb);
+    _nodes[new_parent].height = _nodes[sibling].height + 1;
+    _nodes[new_parent].child1 = sibling;
+    _nodes[new_parent].child2 = leaf;
+    _nodes[sibling].parent = new_parent;
+    _nodes[leaf].parent = new_parent;
+
+    if (old_parent != NULL_NODE) {
+        if (_nodes[old_parent].child1 == sibling) {
+            _nodes[old_parent].child1 = new_parent;
+        } else {
+            _nodes[old_parent].child2 = new_parent;
+        }
+    } else {
+        _root = new_parent;
+    }
+
+    refit(_nodes[leaf].parent);
+}
+
+void DynamicTreeBroadPhase::removeLeaf(int32_t leaf) {
+    if (leaf == _root) {
+        _root = NULL_NODE;
+        return;
+    }
+
+    const int32_t parent = _nodes[leaf].parent;
+    const int32_t grand_parent = _nodes[parent].parent;
+    const int32_t sibling = _nodes[parent].child1 == leaf
+                                ? _nodes[parent].child2
+                                : _nodes[parent].child1;
+
+    if (grand_parent != NULL_NODE) {
+        // connect the sibling to the grand parent and destroy the parent
+        if (_nodes[grand_parent].child1 == parent) {
+            _nodes[grand_parent].child1 = sibling;
+        } else {
+            _nodes[grand_parent].child2 = sibling;
         }
+        _nodes[sibling].parent = grand_parent;
+        freeNode(parent);
+        refit(grand_parent);
+    } else {
+        _root = sibling;
+        _nodes[sibling].parent = NULL_NODE;
+        freeNode(parent);
     }
+}
+
+void DynamicTreeBroadPhase::refit(int32_t index) {
+    while (index != NULL_NODE) {
+        index = balance(index);
+
+        Node       &node = _nodes[index];
+        const Node &child1 = _nodes[node.child1];
+        const Node &child2 = _nodes[node.child2];
+        node.height = 1 + std::max(child1.height, child2.height);
+        node.aabb = aabbUnion(child1.aabb, child2.aabb);
+
+        index = node.parent;
+    }
+}
+
+int32_t DynamicTreeBroadPhase::balance(int32_t iA) {
+    Node *A = &_nodes[iA];
+    if (A->isLeaf() || A->height < 2) {
+        return iA;
+    }
+
+    const int32_t iB = A->child1;
+    const int32_t iC = A->child2;
+    Node         *B = &_nodes[iB];
+    Node         *C = &_nodes[iC];
 
-    // finally copy the collision pairs to the vector
-    for (const auto &pair : collision_pair_set) {
-        _collision_pairs.emplace_back(pair);
+    // replace child old with child new in the parent (or the root)
+    auto replace_in_parent = [this](int32_t parent, int32_t old_child,
+                                    int32_t new_child) {
+        if (parent == NULL_NODE) {
+            _root = new_child;
+        } else if (_nodes[parent].child1 == old_child) {
+            _nodes[parent].child1 = new_child;
+        } else {
+            _nodes[parent].child2 = new_child;
+        }
+    };
+
+    const int32_t bal = C->height - B->height;
+
+    // rotate C up
+    if (bal > 1) {
+        const int32_t iF = C->child1;
+        const int32_t iG = C->child2;
+        Node         *F = &_nodes[iF];
+        Node         *G = &_nodes[iG];
+
+        // swap A and C
+        C->child1 = iA;
+        C->parent = A->parent;
+        A->parent = iC;
+        replace_in_parent(C->parent, iA, iC);
+
+        if (F->height > G->height) {
+            C->child2 = iF;
+            A->child2 = iG;
+            G->parent = iA;
+            A->aabb = aabbUnion(B->aabb, G->aabb);
+            C->aabb = aabbUnion(A->aabb, F->aabb);
+            A->height = 1 + std::max(B->height, G->height);
+            C->height = 1 + std::max(A->height, F->height);
+        } else {
+            C->child2 = iG;
+            A->child2 = iF;
+            F->parent = iA;
+            A->aabb = aabbUnion(B->aabb, F->aabb);
+            C->aabb = aabbUnion(A->aabb, G->aabb);
+            A->height = 1 + std::max(B->height, F->height);
+            C->height = 1 + std::max(A->height, G->height);
+        }
+        return iC;
+    }
+
+    // rotate B up
+    if (bal < -1) {
+        const int32_t iD = B->child1;
+        const int32_t iE = B->child2;
+        Node         *D = &_nodes[iD];
+        Node         *E = &_nodes[iE];
+
+        // swap A and B
+        B->child1 = iA;
+        B->parent = A->parent;
+        A->parent = iB;
+        replace_in_parent(B->parent, iA, iB);
+
+        if (D->height > E->height) {
+            B->child2 = iD;
+            A->child1 = iE;
+            E->parent = iA;
+            A->aabb = aabbUnion(C->aabb, E->aabb);
+            B->aabb = aabbUnion(A->aabb, D->aabb);
+            A->height = 1 + std::max(C->height, E->height);
+            B->height = 1 + std::max(A->height, D->height);
+        } else {
+            B->child2 = iE;
+            A->child1 = iD;
+            D->parent = iA;
+            A->aabb = aabbUnion(C->aabb, D->aabb);
+            B->aabb = aabbUnion(A->aabb, E->aabb);
+            A->height = 1 + std::max(C->height, D->height);
+            B->height = 1 + std::max(A->height, E->height);
+        }
+        return iB;
+    }
+
+    return iA;
+}
+
+void DynamicTreeBroadPhase::generateCollisionPairs() {
+    _collision_pairs.clear();
+
+    // refresh the leaves from the bounds written by the physics system.  Only
+    // leaves that escaped their fat bounds are reinserted.
+    for (const int32_t leaf : _leaves) {
+        Node &node = _nodes[leaf];
+        node.tight_aabb = _col_sys.getBaseColliderData(node.hndl).aabb;
+        if (aabbContains(node.aabb, node.tight_aabb)) {
+            continue;
+        }
+        removeLeaf(leaf);
+        _nodes[leaf].aabb = {
+            _nodes[leaf].tight_aabb.mn - glm::vec2(_fat_margin),
+            _nodes[leaf].tight_aabb.mx + glm::vec2(_fat_margin)};
+        insertLeaf(leaf);
+    }
+
+    // query each leaf against the tree.  Overlap is symmetric so a pair is
+    // only reported from the leaf with the lower node index.
+    for (const int32_t leaf : _leaves) {
+        const aabb_2d_t query = _nodes[leaf].tight_aabb;
+        _stack.clear();
+        _stack.push_back(_root);
+        while (_stack.empty() == false) {
+            const int32_t index = _stack.back();
+            _stack.pop_back();
+            const Node &node = _nodes[index];
+            if (aabbOverlap(node.aabb, query) == false) {
+                continue;
+            }
+            if (node.isLeaf() == false) {
+                _stack.push_back(node.child1);
+                _stack.push_back(node.child2);
+                continue;
+            }
+            if (index <= leaf || aabbOverlap(node.tight_aabb, query) == false ||
+                _col_sys.shouldCollide(_nodes[leaf].hndl, node.hndl) == false) {
+                continue;
+            }
+            CollisionPair pair;
+            pair.a = _nodes[leaf].hndl;
+            pair.b = node.hndl;
+            _collision_pairs.push_back(pair);
+        }
+    }
+}
+
+bool VerletListBroadPhase::needsRebuild() const {
+    const ComponentStore<ColliderHandle> &colliders = _col_sys.colliders();
+    if (_dirty || _build_aabbs.size() != colliders.size() ||
+        _filter_revision != _col_sys.filterRevision()) {
+        return true;
+    }
+    const float half_skin = 0.5f * _skin;
+    for (size_t i = 0; i < colliders.size(); i++) {
+        const aabb_2d_t &aabb = _col_sys.getBaseColliderData(colliders.at(i)).aabb;
+        const aabb_2d_t &built = _build_aabbs[i];
+        const glm::vec2  d = glm::max(glm::abs(aabb.mn - built.mn),
+                                      glm::abs(aabb.mx - built.mx));
+        if (d.x > half_skin || d.y > half_skin) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void VerletListBroadPhase::rebuild() {
+    const ComponentStore<ColliderHandle> &colliders = _col_sys.colliders();
+    const size_t                          num_colliders = colliders.size();
+    _collision_pairs.clear();
+    _dirty = false;
+    _filter_revision = _col_sys.filterRevision();
+
+    // inflate by half the skin on each side.  Two colliders that do not
+    // overlap now are more than a skin apart, so they cannot touch before
+    // one of them has moved more than half the skin.
+    const glm::vec2 half_skin(0.5f * _skin);
+    _build_aabbs.resize(num_colliders);
+    _sorted.resize(num_colliders);
+    for (size_t i = 0; i < num_colliders; i++) {
+        _build_aabbs[i] = _col_sys.getBaseColliderData(colliders.at(i)).aabb;
+        _sorted[i] = uint32_t(i);
+    }
+    std::sort(_sorted.begin(), _sorted.end(), [this](uint32_t a, uint32_t b) {
+        return _build_aabbs[a].mn.x < _build_aabbs[b].mn.x;
+    });
+
+    // sort and sweep over the inflated bounds
+    for (size_t i = 0; i < num_colliders; i++) {
+        const uint32_t  c1 = _sorted[i];
+        const aabb_2d_t a = {_build_aabbs[c1].mn - half_skin,
+                             _build_aabbs[c1].mx + half_skin};
+        for (size_t p = i + 1; p < num_colliders; p++) {
+            const uint32_t  c2 = _sorted[p];
+            const aabb_2d_t b = {_build_aabbs[c2].mn - half_skin,
+                                 _build_aabbs[c2].mx + half_skin};
+            if (b.mn.x > a.mx.x) {
+                break;
+            }
+            if (a.mn.y <= b.mx.y && b.mn.y <= a.mx.y &&
+                _col_sys.shouldCollide(colliders.at(c1), colliders.at(c2))) {
+                CollisionPair pair;
+                pair.a = colliders.at(c1);
+                pair.b = colliders.at(c2);
+                _collision_pairs.push_back(pair);
+            }
+        }
+    }
+}
+
+void VerletListBroadPhase::generateCollisionPairs() {
+    if (needsRebuild()) {
+        rebuild();
+    }
+}
+
+void BruteForceBroadPhase::generateCollisionPairs() {
+    const ComponentStore<ColliderHandle> &colliders = _col_sys.colliders();
+    const size_t                          num_colliders = colliders.size();
+    _collision_pairs.clear();
+
+    // gather the bounds into SoA arrays.  The arrays are padded with empty
+    // (inverted) boxes so the SIMD loop can always load a full register.
+    const size_t padded_size = num_colliders + LANES;
+    const float  inf = std::numeric_limits<float>::infinity();
+    _mn_x.assign(padded_size, inf);
+    _mn_y.assign(padded_size, inf);
+    _mx_x.assign(padded_size, -inf);
+    _mx_y.assign(padded_size, -inf);
+    for (size_t i = 0; i < num_colliders; i++) {
+        const aabb_2d_t &aabb =
+            _col_sys.getBaseColliderData(colliders.at(i)).aabb;
+        _mn_x[i] = aabb.mn.x;
+        _mn_y[i] = aabb.mn.y;
+        _mx_x[i] = aabb.mx.x;
+        _mx_y[i] = aabb.mx.y;
+    }
+
+    auto emit = [&](size_t i, size_t p) {
+        if (_col_sys.shouldCollide(colliders.at(i), colliders.at(p)) == false) {
+            return;
+        }
+        CollisionPair pair;
+        pair.a = colliders.at(i);
+        pair.b = colliders.at(p);
+        _collision_pairs.push_back(pair);
+    };
+
+    for (size_t i = 0; i < num_colliders; i++) {
+        size_t p = i + 1;
+#if defined(__AVX2__)
+        const __m256 mn_x = _mm256_set1_ps(_mn_x[i]);
+        const __m256 mn_y = _mm256_set1_ps(_mn_y[i]);
+        const __m256 mx_x = _mm256_set1_ps(_mx_x[i]);
+        const __m256 mx_y = _mm256_set1_ps(_mx_y[i]);
+        for (; p < num_colliders; p += 8) {
+            __m256 overlap = _mm256_and_ps(
+                _mm256_cmp_ps(mn_x, _mm256_loadu_ps(&_mx_x[p]), _CMP_LE_OQ),
+                _mm256_cmp_ps(_mm256_loadu_ps(&_mn_x[p]), mx_x, _CMP_LE_OQ));
+            overlap = _mm256_and_ps(
+                overlap,
+                _mm256_cmp_ps(mn_y, _mm256_loadu_ps(&_mx_y[p]), _CMP_LE_OQ));
+            overlap = _mm256_and_ps(
+                overlap,
+                _mm256_cmp_ps(_mm256_loadu_ps(&_mn_y[p]), mx_y, _CMP_LE_OQ));
+            uint32_t mask = uint32_t(_mm256_movemask_ps(overlap));
+            while (mask) {
+                emit(i, p + std::countr_zero(mask));
+                mask &= mask - 1;
+            }
+        }
+#elif defined(__SSE2__) || defined(_M_X64)
+        const __m128 mn_x = _mm_set1_ps(_mn_x[i]);
+        const __m128 mn_y = _mm_set1_ps(_mn_y[i]);
+        const __m128 mx_x = _mm_set1_ps(_mx_x[i]);
+        const __m128 mx_y = _mm_set1_ps(_mx_y[i]);
+        for (; p < num_colliders; p += 4) {
+            __m128 overlap =
+                _mm_and_ps(_mm_cmple_ps(mn_x, _mm_loadu_ps(&_mx_x[p])),
+                           _mm_cmple_ps(_mm_loadu_ps(&_mn_x[p]), mx_x));
+            overlap = _mm_and_ps(
+                overlap, _mm_cmple_ps(mn_y, _mm_loadu_ps(&_mx_y[p])));
+            overlap = _mm_and_ps(
+                overlap, _mm_cmple_ps(_mm_loadu_ps(&_mn_y[p]), mx_y));
+            uint32_t mask = uint32_t(_mm_movemask_ps(overlap));
+            while (mask) {
+                emit(i, p + std::countr_zero(mask));
+                mask &= mask - 1;
+            }
+        }
+#else
+        for (; p < num_colliders; p++) {
+            if (_mn_x[i] <= _mx_x[p] && _mn_x[p] <= _mx_x[i] &&
+                _mn_y[i] <= _mx_y[p] && _mn_y[p] <= _mx_y[i]) {
+                emit(i, p);
+            }
+        }
+#endif
+    }
+}
+
+int64_t HierarchicalGridBroadPhase::cellCoord(float p, float inv_cell_size) {
+    // keep well inside the key range so neighbors of a cell never wrap
+    // and clamp before converting, out of range floats don't convert
+    constexpr float LIMIT = float(int64_t(1) << 30);
+    p = std::floor(p * inv_cell_size);
+    if ((p >= -LIMIT) == false) {
+        return -(int64_t(1) << 30); // also NaN
+    }
+    return p < LIMIT ? int64_t(p) : (int64_t(1) << 30);
+}
+
+void HierarchicalGridBroadPhase::generateCollisionPairs() {
+    const ComponentStore<ColliderHandle> &colliders = _col_sys.colliders();
+    const size_t                          num_colliders = colliders.size();
+    _collision_pairs.clear();
+    for (std::vector<Entry> &level : _levels) {
+        level.clear();
+    }
+
+    // insert each collider by its center into the level that fits its size
+    _aabbs.resize(num_colliders);
+    _collider_levels.resize(num_colliders);
+    int max_level = 0;
+    for (size_t i = 0; i < num_colliders; i++) {
+        const aabb_2d_t &aabb =
+            _col_sys.getBaseColliderData(colliders.at(i)).aabb;
+        _aabbs[i] = aabb;
+
+        const glm::vec2 extent = aabb.mx - aabb.mn;
+        const float     size = std::max(extent.x, extent.y);
+        int             level = 0;
+        if (size > _cell_size) {
+            // clamp in float, an infinite size has no int level
+            const float fit = std::ceil(std::log2(size / _cell_size));
+            level = fit < float(MAX_LEVELS - 1) ? int(fit) : MAX_LEVELS - 1;
+        }
+        _collider_levels[i] = uint8_t(level);
+        max_level = std::max(max_level, level);
+
+        const float     inv_cell_size = 1.0f / std::ldexp(_cell_size, level);
+        const glm::vec2 center = 0.5f * (aabb.mn + aabb.mx);
+        _levels[level].push_back(
+            {cellKey(cellCoord(center.x, inv_cell_size),
+                     cellCoord(center.y, inv_cell_size)),
+             uint32_t(i)});
+    }
+    for (int level = 0; level <= max_level; level++) {
+        std::sort(_levels[level].begin(), _levels[level].end());
+    }
+
+    // query the 3x3 neighborhood on the collider's own level and every
+    // coarser level.  A pair on the same level is found from both sides so
+    // only the lower index reports it.
+    for (size_t i = 0; i < num_colliders; i++) {
+        const aabb_2d_t &aabb = _aabbs[i];
+        const glm::vec2  center = 0.5f * (aabb.mn + aabb.mx);
+        const int        own_level = _collider_levels[i];
+        for (int level = own_level; level <= max_level; level++) {
+            const std::vector<Entry> &entries = _levels[level];
+            if (entries.empty()) {
+                continue;
+            }
+            const float   inv_cell_size = 1.0f / std::ldexp(_cell_size, level);
+            const int64_t cx = cellCoord(center.x, inv_cell_size);
+            const int64_t cy = cellCoord(center.y, inv_cell_size);
+            for (int64_t y = cy - 1; y <= cy + 1; y++) {
+                const uint64_t last = cellKey(cx + 1, y);
+                auto it = std::lower_bound(entries.begin(), entries.end(),
+                                           Entry{cellKey(cx - 1, y), 0});
+                for (; it != entries.end() && it->key <= last; ++it) {
+                    const uint32_t p = it->collider;
+                    if (level == own_level && p <= i) {
+                        continue;
+                    }
+                    if (aabbOverlap(aabb, _aabbs[p]) == false ||
+                        _col_sys.shouldCollide(colliders.at(i),
+                                               colliders.at(p)) == false) {
+                        continue;
+                    }
+                    CollisionPair pair;
+                    pair.a = colliders.at(i);
+                    pair.b = colliders.at(p);
+                    _collision_pairs.push_back(pair);
+                }
+            }
+        }
+    }
+}
+
+uint32_t LinearBvhBroadPhase::mortonCode(uint32_t x, uint32_t y) {
+    // spread the bits of a 15 bit value so there is a zero between each
+    auto expand = [](uint32_t v) {
+        v &= 0x00007fff;
+        v = (v | (v << 8)) & 0x00ff00ff;
+        v = (v | (v << 4)) & 0x0f0f0f0f;
+        v = (v | (v << 2)) & 0x33333333;
+        v = (v | (v << 1)) & 0x55555555;
+        return v;
+    };
+    return expand(x) | (expand(y) << 1);
+}
+
+void LinearBvhBroadPhase::radixSort() {
+    constexpr uint32_t RADIX_BITS = 10;
+    constexpr uint32_t BUCKETS = 1 << RADIX_BITS;
+    _sort_buffer.resize(_leaves.size());
+    std::array<uint32_t, BUCKETS> offsets;
+    for (uint32_t shift = 0; shift < 30; shift += RADIX_BITS) {
+        offsets.fill(0);
+        for (const Leaf &leaf : _leaves) {
+            offsets[(leaf.code >> shift) & (BUCKETS - 1)]++;
+        }
+        uint32_t sum = 0;
+        for (uint32_t &offset : offsets) {
+            const uint32_t count = offset;
+            offset = sum;
+            sum += count;
+        }
+        for (const Leaf &leaf : _leaves) {
+            _sort_buffer[offsets[(leaf.code >> shift) & (BUCKETS - 1)]++] =
+                leaf;
+        }
+        _leaves.swap(_sort_buffer);
+    }
+}
+
+void LinearBvhBroadPhase::generateCollisionPairs() {
+    const ComponentStore<ColliderHandle> &colliders = _col_sys.colliders();
+    const size_t                          num_colliders = colliders.size();
+    WorkerPool                           &pool = _col_sys.workerPool();
+    _collision_pairs.clear();
+    if (num_colliders < 2) {
+        return;
+    }
+
+    // gather the bounds and the bounds of the centers.  Inverted or NaN
+    // bounds are left out of the tree, they would poison the node bounds.
+    _aabbs.resize(num_colliders);
+    _leaves.clear();
+    glm::vec2 mn(std::numeric_limits<float>::max());
+    glm::vec2 mx(-std::numeric_limits<float>::max());
+    for (size_t i = 0; i < num_colliders; i++) {
+        _aabbs[i] = _col_sys.getBaseColliderData(colliders.at(i)).aabb;
+        if ((_aabbs[i].mn.x <= _aabbs[i].mx.x &&
+             _aabbs[i].mn.y <= _aabbs[i].mx.y) == false) {
+            continue;
+        }
+        _leaves.push_back({0, uint32_t(i)});
+        const glm::vec2 center = 0.5f * (_aabbs[i].mn + _aabbs[i].mx);
+        mn = glm::min(mn, center);
+        mx = glm::max(mx, center);
+    }
+    const size_t num_leaves = _leaves.size();
+    if (num_leaves < 2) {
+        return;
+    }
+
+    // quantize the centers to 15 bits per axis and compute the codes
+    constexpr float QUANTIZE = float((1 << 15) - 1);
+    const glm::vec2 extent = glm::max(mx - mn, glm::vec2(EPSILON));
+    const glm::vec2 scale = glm::vec2(QUANTIZE) / extent;
+    const auto      quantize = [](float q) {
+        // clamp before converting, NaN and infinite centers don't convert
+        if ((q > 0) == false) {
+            return 0u; // also NaN
+        }
+        return q < QUANTIZE ? uint32_t(q) : uint32_t(QUANTIZE);
+    };
+    pool.parallelFor(num_leaves, [&](size_t begin, size_t end, size_t) {
+        for (size_t i = begin; i < end; i++) {
+            const aabb_2d_t &aabb = _aabbs[_leaves[i].collider];
+            const glm::vec2  q = (0.5f * (aabb.mn + aabb.mx) - mn) * scale;
+            _leaves[i].code = mortonCode(quantize(q.x), quantize(q.y));
+        }
+    });
+    radixSort();
+
+    // build the levels bottom up.  An odd node at the end of a level is
+    // carried up unchanged.
+    _level_offsets.clear();
+    _level_sizes.clear();
+    _nodes.resize(num_leaves);
+    for (size_t i = 0; i < num_leaves; i++) {
+        _nodes[i] = _aabbs[_leaves[i].collider];
+    }
+    _level_offsets.push_back(0);
+    _level_sizes.push_back(num_leaves);
+    while (_level_sizes.back() > 1) {
+        const size_t child_offset = _level_offsets.back();
+        const size_t child_size = _level_sizes.back();
+        const size_t offset = _nodes.size();
+        const size_t size = (child_size + 1) / 2;
+        _nodes.resize(offset + size);
+        for (size_t k = 0; k < size; k++) {
+            const size_t c = child_offset + 2 * k;
+            _nodes[offset + k] = 2 * k + 1 < child_size
+                                     ? aabbUnion(_nodes[c], _nodes[c + 1])
+                                     : _nodes[c];
+        }
+        _level_offsets.push_back(offset);
+        _level_sizes.push_back(size);
+    }
+
+    // query every leaf against the tree
+    if (pool.numThreads() == 1) {
+        queryLeaves(0, num_leaves, _collision_pairs);
+        return;
+    }
+    _thread_pairs.resize(pool.numThreads());
+    for (std::vector<CollisionPair> &pairs : _thread_pairs) {
+        pairs.clear();
+    }
+    pool.parallelFor(num_leaves,
+                     [this](size_t begin, size_t end, size_t worker) {
+                         queryLeaves(begin, end, _thread_pairs[worker]);
+                     });
+
+    // merge in worker (i.e., leaf) order so the result is deterministic
+    for (const std::vector<CollisionPair> &pairs : _thread_pairs) {
+        _collision_pairs.insert(_collision_pairs.end(), pairs.begin(),
+                                pairs.end());
+    }
+}
+
+void LinearBvhBroadPhase::queryLeaves(size_t begin, size_t end,
+                                      std::vector<CollisionPair> &pairs) const {
+    const ComponentStore<ColliderHandle> &colliders = _col_sys.colliders();
+    const int top_level = int(_level_sizes.size()) - 1;
+
+    // (level, node) stack.  The depth is log2(N) so a fixed stack is enough.
+    std::array<std::pair<int, size_t>, 128> stack;
+    for (size_t i = begin; i < end; i++) {
+        const aabb_2d_t &query = _nodes[i];
+        const uint32_t   collider = _leaves[i].collider;
+        int              top = 0;
+        stack[top++] = {top_level, 0};
+        while (top > 0) {
+            const auto [level, k] = stack[--top];
+
+            // a pair is only reported by the leaf that comes first in sorted
+            // order so skip nodes that only cover earlier leaves
+            if (((k + 1) << level) - 1 <= i) {
+                continue;
+            }
+            if (aabbOverlap(_nodes[_level_offsets[level] + k], query) == false) {
+                continue;
+            }
+            if (level == 0) {
+                const uint32_t other = _leaves[k].collider;
+                if (_col_sys.shouldCollide(colliders.at(collider),
+                                           colliders.at(other))) {
+                    CollisionPair pair;
+                    pair.a = colliders.at(collider);
+                    pair.b = colliders.at(other);
+                    pairs.push_back(pair);
+                }
+                continue;
+            }
+            const size_t child = 2 * k;
+            if (child + 1 < _level_sizes[level - 1]) {
+                stack[top++] = {level - 1, child + 1};
+            }
+            stack[top++] = {level - 1, child};
+        }
+    }
+}
+
+int SpatialHashBroadPhase::cellCoord(float p, float inv_cell_size) {
+    // clamp before converting, out of range floats don't convert to int
+    constexpr float LIMIT = float(1 << 30);
+    p = std::floor(p * inv_cell_size);
+    if ((p >= -LIMIT) == false) {
+        return -(1 << 30); // also NaN
+    }
+    return p < LIMIT ? int(p) : (1 << 30);
+}
+
+uint32_t SpatialHashBroadPhase::hashCell(int32_t x, int32_t y) {
+    // pack both coordinates and run the splitmix64 finalizer so diagonal and
+    // mirrored cells do not collide
+    uint64_t h = (uint64_t(uint32_t(x)) << 32) | uint32_t(y);
+    h ^= h >> 30;
+    h *= 0xbf58476d1ce4e5b9ull;
+    h ^= h >> 27;
+    h *= 0x94d049bb133111ebull;
+    h ^= h >> 31;
+    return uint32_t(h);
+}
+
+uint32_t SpatialHashBroadPhase::findOrInsert(int32_t x, int32_t y) {
+    const uint32_t mask = uint32_t(_slots.size() - 1);
+    uint32_t       idx = hashCell(x, y) & mask;
+    while (true) {
+        Slot &slot = _slots[idx];
+        if (slot.count == 0) {
+            slot = {x, y, 0, 1};
+            _occupied.push_back(idx);
+            return idx;
+        }
+        if (slot.x == x && slot.y == y) {
+            slot.count++;
+            return idx;
+        }
+        idx = (idx + 1) & mask;
+    }
+}
+
+void SpatialHashBroadPhase::generateCollisionPairs() {
+    const ComponentStore<ColliderHandle> &colliders = _col_sys.colliders();
+    const size_t                          num_colliders = colliders.size();
+    _collision_pairs.clear();
+
+    // clear the slots used last frame
+    for (uint32_t idx : _occupied) {
+        _slots[idx].count = 0;
+    }
+    _occupied.clear();
+    if (num_colliders < 2) {
+        return;
+    }
+
+    // compute the cell ranges
+    const float inv_cell_size = 1.0f / _cell_size;
+    _aabbs.resize(num_colliders);
+    _cell_ranges.resize(num_colliders);
+    _oversized.clear();
+    size_t num_entries = 0;
+    for (size_t i = 0; i < num_colliders; i++) {
+        _aabbs[i] = _col_sys.getBaseColliderData(colliders.at(i)).aabb;
+        const aabb_2d_t &aabb = _aabbs[i];
+        CellRange       &range = _cell_ranges[i];
+        range = {cellCoord(aabb.mn.x, inv_cell_size),
+                 cellCoord(aabb.mn.y, inv_cell_size),
+                 cellCoord(aabb.mx.x, inv_cell_size),
+                 cellCoord(aabb.mx.y, inv_cell_size)};
+        const int64_t num_cells = (int64_t(range.mx_x) - range.mn_x + 1) *
+                                  (int64_t(range.mx_y) - range.mn_y + 1);
+        if (num_cells > MAX_CELLS_PER_COLLIDER) {
+            _oversized.push_back(uint32_t(i));
+            continue;
+        }
+        num_entries += size_t(num_cells);
+    }
+
+    // keep the table at most half full.  It only ever grows.
+    const size_t capacity = std::bit_ceil(std::max<size_t>(num_entries * 2, 64));
+    if (_slots.size() < capacity) {
+        _slots.assign(capacity, Slot{0, 0, 0, 0});
+    }
+
+    // insert the cells counting the colliders in each, remembering the slot
+    // of every entry for the scatter below
+    _entry_slots.clear();
+    for (size_t i = 0; i < num_colliders; i++) {
+        const CellRange &range = _cell_ranges[i];
+        const int64_t    num_cells = (int64_t(range.mx_x) - range.mn_x + 1) *
+                                  (int64_t(range.mx_y) - range.mn_y + 1);
+        if (num_cells > MAX_CELLS_PER_COLLIDER) {
+            continue;
+        }
+        for (int y = range.mn_y; y <= range.mx_y; y++) {
+            for (int x = range.mn_x; x <= range.mx_x; x++) {
+                _entry_slots.push_back(findOrInsert(x, y));
+            }
+        }
+    }
+
+    // prefix sum the counts into start offsets (in insertion order) and
+    // scatter the collider indices.  The starts are used as write cursors
+    // and restored afterwards.
+    uint32_t start = 0;
+    for (uint32_t idx : _occupied) {
+        _slots[idx].start = start;
+        start += _slots[idx].count;
+    }
+    _cell_entries.resize(start);
+    size_t entry = 0;
+    for (size_t i = 0; i < num_colliders; i++) {
+        const CellRange &range = _cell_ranges[i];
+        const int64_t    num_cells = (int64_t(range.mx_x) - range.mn_x + 1) *
+                                  (int64_t(range.mx_y) - range.mn_y + 1);
+        if (num_cells > MAX_CELLS_PER_COLLIDER) {
+            continue;
+        }
+        for (int64_t c = 0; c < num_cells; c++) {
+            _cell_entries[_slots[_entry_slots[entry++]].start++] = uint32_t(i);
+        }
+    }
+    for (uint32_t idx : _occupied) {
+        _slots[idx].start -= _slots[idx].count;
+    }
+
+    // generate pairs within each occupied cell
+    WorkerPool &pool = _col_sys.workerPool();
+    if (pool.numThreads() == 1) {
+        generateSlotPairs(0, _occupied.size(), _collision_pairs);
+    } else {
+        _thread_pairs.resize(pool.numThreads());
+        for (std::vector<CollisionPair> &pairs : _thread_pairs) {
+            pairs.clear();
+        }
+        pool.parallelFor(_occupied.size(), [this](size_t begin, size_t end,
+                                                  size_t worker) {
+            generateSlotPairs(begin, end, _thread_pairs[worker]);
+        });
+
+        // merge in worker (i.e., slot) order so the result is deterministic
+        for (const std::vector<CollisionPair> &pairs : _thread_pairs) {
+            _collision_pairs.insert(_collision_pairs.end(), pairs.begin(),
+                                    pairs.end());
+        }
+    }
+
+    // oversized colliders are tested against everything else
+    for (size_t o = 0; o < _oversized.size(); o++) {
+        const uint32_t c1 = _oversized[o];
+        for (size_t c2 = 0; c2 < num_colliders; c2++) {
+            // pairs of two oversized colliders are reported once
+            if (c2 == c1 ||
+                (c2 < c1 && std::binary_search(_oversized.begin(),
+                                               _oversized.end(), c2))) {
+                continue;
+            }
+            if (aabbOverlap(_aabbs[c1], _aabbs[c2]) == false) {
+                continue;
+            }
+            if (_col_sys.shouldCollide(colliders.at(c1), colliders.at(c2)) ==
+                false) {
+                continue;
+            }
+            CollisionPair pair;
+            pair.a = colliders.at(c1);
+            pair.b = colliders.at(c2);
+            _collision_pairs.push_back(pair);
+        }
+    }
+}
+
+void SpatialHashBroadPhase::generateSlotPairs(
+    size_t begin, size_t end, std::vector<CollisionPair> &pairs) const {
+    const ComponentStore<ColliderHandle> &colliders = _col_sys.colliders();
+    for (size_t s = begin; s < end; s++) {
+        const Slot    &slot = _slots[_occupied[s]];
+        const uint32_t first = slot.start;
+        const uint32_t last = slot.start + slot.count;
+        for (uint32_t i = first; i < last; i++) {
+            const uint32_t   c1 = _cell_entries[i];
+            const CellRange &r1 = _cell_ranges[c1];
+            for (uint32_t p = i + 1; p < last; p++) {
+                const uint32_t   c2 = _cell_entries[p];
+                const CellRange &r2 = _cell_ranges[c2];
+
+                // only the cell owning the pair reports it
+                if (std::max(r1.mn_x, r2.mn_x) != slot.x ||
+                    std::max(r1.mn_y, r2.mn_y) != slot.y) {
+                    continue;
+                }
+                if (aabbOverlap(_aabbs[c1], _aabbs[c2]) == false) {
+                    continue;
+                }
+                if (_col_sys.shouldCollide(colliders.at(c1),
+                                           colliders.at(c2)) == false) {
+                    continue;
+                }
+                CollisionPair pair;
+                pair.a = colliders.at(c1);
+                pair.b = colliders.at(c2);
+                pairs.push_back(pair);
+            }
+        }
     }
 }
 } // namespace zo
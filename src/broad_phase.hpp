@@ -11,11 +11,88 @@
 #ifndef __broaphase_h__
 #define __broaphase_h__
 #include "types_impl.hpp"
+#include <zero_physics/memory.hpp>
 #include <vector>
+#include <array>
+#include <unordered_map>
 
 namespace zo {
 class CollisionSystem2dImpl;
 
+/// @brief Bounding volume hierarchy over the static colliders.
+/// Static colliders never move so the tree is built once, top down with
+/// median splits into a flat node array, and only rebuilt when the static
+/// set changes.  Dynamic colliders are queried against it.
+class StaticColliderTree {
+  public:
+    /// @brief Build the tree from the static collider store
+    void build(const CollisionSystem2dImpl           &collision_system,
+               const ComponentStore<ColliderHandle> &colliders);
+
+    bool empty() const { return _nodes.empty(); }
+
+    /// @brief Call callback(const ColliderHandle &) for every static
+    /// collider whose AABB overlaps aabb.
+    template <typename Callback>
+    void query(const aabb_2d_t &aabb, Callback &&callback) const {
+        // median splits keep the depth at log2(N) so a small fixed stack
+        // is plenty
+        uint32_t stack[64];
+        int      top = 0;
+        stack[top++] = 0;
+        while (top > 0) {
+            const Node &node = _nodes[stack[--top]];
+            if (overlaps(node.aabb, aabb) == false) {
+                continue;
+            }
+            if (node.count > 0) {
+                for (uint32_t i = node.first; i < node.first + node.count;
+                     i++) {
+                    if (overlaps(_items[i].aabb, aabb)) {
+                        callback(_items[i].hndl);
+                    }
+                }
+                continue;
+            }
+            // the left child directly follows its parent
+            stack[top++] = node.right;
+            stack[top++] = uint32_t(&node - _nodes.data()) + 1;
+        }
+    }
+
+  private:
+    static constexpr uint32_t LEAF_SIZE = 4;
+
+    struct Item {
+        ColliderHandle hndl;
+        aabb_2d_t      aabb;
+    };
+
+    struct Node {
+        aabb_2d_t aabb;
+        /// @brief first item and item count for leaves (count == 0 for
+        /// interior nodes)
+        uint32_t first = 0;
+        uint32_t count = 0;
+        /// @brief right child of an interior node
+        uint32_t right = 0;
+    };
+
+    static bool overlaps(const aabb_2d_t &a, const aabb_2d_t &b) {
+        return a.mn.x <= b.mx.x && b.mn.x <= a.mx.x && a.mn.y <= b.mx.y &&
+               b.mn.y <= a.mx.y;
+    }
+
+    uint32_t buildNode(uint32_t begin, uint32_t end);
+
+  private:
+    std::vector<Item> _items;
+    std::vector<Node> _nodes;
+};
+
+/// @brief Broad phase collision detection interface.
+/// Implementations only emit pairs that pass the collision filter. See:
+/// CollisionSystem2dImpl::shouldCollide.
 class BroadPhase {
   public:
     virtual ~BroadPhase() = default;
@@ -26,6 +103,15 @@ class BroadPhase {
     virtual void                              generateCollisionPairs() = 0;
     virtual const std::vector<CollisionPair> &collisionPairs() const = 0;
 
+    /// @brief Called by the collision system when a collider is created.
+    /// Broad phases that keep persistent per collider state override this.
+    /// @param hndl the new collider
+    virtual void addCollider(const ColliderHandle & /*hndl*/) {}
+
+    /// @brief Called by the collision system before a collider is destroyed.
+    /// @param hndl the collider being destroyed
+    virtual void removeCollider(const ColliderHandle & /*hndl*/) {}
+
   protected:
     CollisionSystem2dImpl &_col_sys;
 };
@@ -47,10 +133,21 @@ class NaiveBroadPhase : public BroadPhase {
     std::vector<CollisionPair> _collision_pairs;
 };
 
+/// @brief Uniform grid broad phase collision detection.
+/// A flat grid rebuilt every frame with a counting sort: colliders are
+/// counted per cell, the counts are prefix summed and the collider indices
+/// are scattered into one contiguous array.  All storage is reused across
+/// frames.  A pair that shares several cells is only reported by the cell at
+/// the minimum corner of the overlap of the two cell ranges.
+/// With more than one thread the cell rows are split into stripes, one per
+/// worker, and the per thread pairs are merged in stripe order so the output
+/// matches the single threaded order.
 class GridBroadPhase : public BroadPhase {
   public:
-    GridBroadPhase(CollisionSystem2dImpl &collision_system, int grid_size)
-        : BroadPhase(collision_system), _grid_size(grid_size) {}
+    GridBroadPhase(CollisionSystem2dImpl &collision_system, float grid_size,
+                   const aabb_2d_t &world_bounds)
+        : BroadPhase(collision_system), _grid_size(grid_size),
+          _world_bounds(world_bounds) {}
 
     void generateCollisionPairs() override;
 
@@ -59,27 +156,399 @@ class GridBroadPhase : public BroadPhase {
     }
 
   private:
-    // Custom hash function for std::pair<int, int>
-    struct pair_hash {
-        template <class T1, class T2>
-        std::size_t operator()(const std::pair<T1, T2> &pair) const {
-            auto hash1 = std::hash<T1>{}(pair.first);
-            auto hash2 = std::hash<T2>{}(pair.second);
-            return hash1 ^ (hash2 << 1); // Combine the two hash values
-        }
+    /// @brief Limit on cells per axis so fit-to-collider bounds with far
+    /// outliers cannot blow up the grid.  Cells are enlarged instead.
+    static constexpr int MAX_CELLS_PER_AXIS = 1024;
+
+    /// @brief Inclusive range of cells covered by a collider
+    struct CellRange {
+        int mn_x, mn_y, mx_x, mx_y;
     };
 
-    struct collision_pair_hash {
-        std::size_t operator()(const CollisionPair &pair) const {
-            auto hash1 = std::hash<uint32_t>{}(pair.a.handle);
-            auto hash2 = std::hash<uint32_t>{}(pair.b.handle);
-            return hash1 ^ (hash2 << 1); // Combine the two hash values
+    /// @brief Convert a position in cells to a cell coordinate (floor) or a
+    /// cell count (ceil) clamped to [0, limit] ([1, limit] for counts).
+    /// NaN gives the lower bound.
+    static int cellCoord(float p, int limit, bool round_up = false);
+
+    /// @brief Generate the pairs owned by a stripe of cell rows
+    /// @param row_begin first row
+    /// @param row_end one past the last row
+    /// @param pairs output pairs
+    void generateRowPairs(int row_begin, int row_end,
+                          std::vector<CollisionPair> &pairs) const;
+
+  private:
+    std::vector<CollisionPair> _collision_pairs;
+    float                      _grid_size = 50;
+    aabb_2d_t                  _world_bounds;
+    int                        _num_x = 0;
+    int                        _num_y = 0;
+
+    // per frame storage, reused across frames
+    std::vector<aabb_2d_t> _aabbs;
+    std::vector<CellRange> _cell_ranges;
+    std::vector<uint32_t>  _cell_starts;
+    std::vector<uint32_t>  _cell_entries;
+
+    // per thread pair buffers for the multi threaded pair generation
+    std::vector<std::vector<CollisionPair>> _thread_pairs;
+};
+
+/// @brief Sweep and prune broad phase collision detection.
+/// Keeps a persistent array of AABB end points along the x axis which is
+/// re-sorted every frame with an insertion sort.  Objects move very little
+/// between frames so the array is nearly sorted and the sort is close to
+/// O(N).  The sweep then only tests the y axis of x overlapping intervals.
+class SweepAndPruneBroadPhase : public BroadPhase {
+  public:
+    SweepAndPruneBroadPhase(CollisionSystem2dImpl &collision_system)
+        : BroadPhase(collision_system) {}
+
+    void addCollider(const ColliderHandle &hndl) override;
+    void removeCollider(const ColliderHandle &hndl) override;
+    void generateCollisionPairs() override;
+
+    const std::vector<CollisionPair> &collisionPairs() const override {
+        return _collision_pairs;
+    }
+
+  private:
+    static constexpr uint32_t INVALID_INDEX = uint32_t(-1);
+
+    /// @brief A collider tracked by the sweep
+    struct Proxy {
+        ColliderHandle hndl;
+        aabb_2d_t      aabb;
+        /// @brief index into the active list during the sweep
+        uint32_t active_idx = INVALID_INDEX;
+        bool     is_valid = false;
+        /// @brief false if the bounds are inverted or NaN
+        bool is_swept = false;
+    };
+
+    /// @brief The start or end of a proxy's interval on the x axis
+    struct EndPoint {
+        float    value;
+        uint32_t proxy;
+        bool     is_max;
+
+        /// @brief sort order.  On ties min end points go first so touching
+        /// intervals are reported as overlapping.
+        bool operator<(const EndPoint &rhs) const {
+            return value < rhs.value ||
+                   (value == rhs.value && !is_max && rhs.is_max);
         }
     };
 
+  private:
+    std::vector<CollisionPair>             _collision_pairs;
+    std::vector<Proxy>                     _proxies;
+    std::vector<uint32_t>                  _free_proxies;
+    std::vector<EndPoint>                  _end_points;
+    std::vector<uint32_t>                  _active;
+    std::unordered_map<uint32_t, uint32_t> _proxy_map;
+};
+
+/// @brief Dynamic AABB tree broad phase collision detection.
+/// A balanced bounding volume hierarchy of collider AABBs.  Each leaf stores
+/// a "fat" AABB enlarged by a margin so a leaf is only reinserted when its
+/// collider leaves the fat box.  Handles mixed collider sizes and unbounded
+/// worlds.  See: Box2D b2DynamicTree.
+class DynamicTreeBroadPhase : public BroadPhase {
+  public:
+    DynamicTreeBroadPhase(CollisionSystem2dImpl &collision_system,
+                          float                  fat_margin = 2.0f)
+        : BroadPhase(collision_system), _fat_margin(fat_margin) {}
+
+    void addCollider(const ColliderHandle &hndl) override;
+    void removeCollider(const ColliderHandle &hndl) override;
+    void generateCollisionPairs() override;
+
+    const std::vector<CollisionPair> &collisionPairs() const override {
+        return _collision_pairs;
+    }
+
+  private:
+    static constexpr int32_t NULL_NODE = -1;
+
+    struct Node {
+        /// @brief enlarged bounds for leaves, union of children otherwise
+        aabb_2d_t aabb;
+        /// @brief the collider's actual bounds (leaves only)
+        aabb_2d_t      tight_aabb;
+        ColliderHandle hndl;
+        /// @brief parent node or the next free node when on the free list
+        int32_t parent = NULL_NODE;
+        int32_t child1 = NULL_NODE;
+        int32_t child2 = NULL_NODE;
+        /// @brief leaf = 0, free node = -1
+        int32_t height = -1;
+        /// @brief index into the leaf list (leaves only)
+        uint32_t leaf_idx = 0;
+
+        bool isLeaf() const { return child1 == NULL_NODE; }
+    };
+
+    int32_t allocateNode();
+    void    freeNode(int32_t node);
+    void    insertLeaf(int32_t leaf);
+    void    removeLeaf(int32_t leaf);
+    /// @brief Walk up from a node restoring balance, height and bounds
+    void refit(int32_t node);
+    /// @brief AVL style rotation to keep the tree balanced
+    /// @return the new root of the sub tree
+    int32_t balance(int32_t node);
+
+  private:
+    std::vector<CollisionPair>            _collision_pairs;
+    std::vector<Node>                     _nodes;
+    std::vector<int32_t>                  _leaves;
+    std::vector<int32_t>                  _stack;
+    std::unordered_map<uint32_t, int32_t> _leaf_map;
+    int32_t                               _root = NULL_NODE;
+    int32_t                               _free_list = NULL_NODE;
+    float                                 _fat_margin = 2.0f;
+};
+
+/// @brief Verlet neighbor list broad phase collision detection.
+/// Candidate pairs are built from collider AABBs inflated by half the skin
+/// distance on each side and cached.  The cached pairs are reused until a
+/// collider's AABB has moved more than half the skin since the last build,
+/// so on most frames only the narrow phase runs.
+/// See: https://en.wikipedia.org/wiki/Verlet_list
+class VerletListBroadPhase : public BroadPhase {
+  public:
+    VerletListBroadPhase(CollisionSystem2dImpl &collision_system, float skin)
+        : BroadPhase(collision_system), _skin(skin) {}
+
+    void addCollider(const ColliderHandle & /*hndl*/) override {
+        _dirty = true;
+    }
+    void removeCollider(const ColliderHandle & /*hndl*/) override {
+        _dirty = true;
+    }
+    void generateCollisionPairs() override;
+
+    const std::vector<CollisionPair> &collisionPairs() const override {
+        return _collision_pairs;
+    }
+
+  private:
+    /// @brief Check if any collider moved more than half the skin
+    bool needsRebuild() const;
+    void rebuild();
+
   private:
     std::vector<CollisionPair> _collision_pairs;
-    int                        _grid_size = 50;
+    float                      _skin = 4.0f;
+    bool                       _dirty = true;
+    uint32_t                   _filter_revision = 0;
+
+    // collider bounds at the last build, indexed like the collider store
+    std::vector<aabb_2d_t> _build_aabbs;
+    // collider store indices sorted by inflated min x
+    std::vector<uint32_t> _sorted;
+};
+
+/// @brief SIMD brute force broad phase collision detection O(N^2).
+/// Stores the collider AABBs as separate min x, min y, max x and max y
+/// arrays and tests 8 (AVX2) or 4 (SSE) boxes per instruction, emitting
+/// only overlapping pairs.  Intended for small worlds (a few hundred
+/// colliders) where the constant factors of the other schemes dominate.
+class BruteForceBroadPhase : public BroadPhase {
+  public:
+    BruteForceBroadPhase(CollisionSystem2dImpl &collision_system)
+        : BroadPhase(collision_system) {}
+
+    void generateCollisionPairs() override;
+
+    const std::vector<CollisionPair> &collisionPairs() const override {
+        return _collision_pairs;
+    }
+
+  private:
+    /// @brief SIMD lane count and padding of the AABB arrays
+    static constexpr size_t LANES = 8;
+
+  private:
+    std::vector<CollisionPair> _collision_pairs;
+    std::vector<float>         _mn_x;
+    std::vector<float>         _mn_y;
+    std::vector<float>         _mx_x;
+    std::vector<float>         _mx_y;
+};
+
+/// @brief Hierarchical grid broad phase collision detection.
+/// A stack of grid levels whose cell size doubles from level to level.  Each
+/// collider is inserted once, by its center, into the finest level whose
+/// cells are at least as large as its AABB.  Overlapping colliders then lie
+/// in neighboring cells so a collider only queries the 3x3 cells around it on
+/// its own level and on every coarser level.  Mixed size scenes stay near
+/// linear since large colliders don't span many small cells.
+/// See: Real-Time Collision Detection, Christer Ericson, 7.2.
+class HierarchicalGridBroadPhase : public BroadPhase {
+  public:
+    HierarchicalGridBroadPhase(CollisionSystem2dImpl &collision_system,
+                               float                  cell_size)
+        : BroadPhase(collision_system), _cell_size(cell_size) {}
+
+    void generateCollisionPairs() override;
+
+    const std::vector<CollisionPair> &collisionPairs() const override {
+        return _collision_pairs;
+    }
+
+  private:
+    static constexpr int MAX_LEVELS = 24;
+
+    /// @brief A collider in a level, sorted by cell key
+    struct Entry {
+        uint64_t key;
+        uint32_t collider;
+
+        bool operator<(const Entry &rhs) const { return key < rhs.key; }
+    };
+
+    /// @brief Row major cell key.  Cells with the same y and consecutive x
+    /// have consecutive keys so a row of cells is one range of entries.
+    static uint64_t cellKey(int64_t x, int64_t y) {
+        return (uint64_t(y + (int64_t(1) << 31)) << 32) |
+               uint64_t(x + (int64_t(1) << 31));
+    }
+
+    /// @brief Cell coordinate of a position at a cell size
+    static int64_t cellCoord(float p, float inv_cell_size);
+
+  private:
+    std::vector<CollisionPair>                 _collision_pairs;
+    float                                      _cell_size = 50.0f;
+    std::array<std::vector<Entry>, MAX_LEVELS> _levels;
+    std::vector<aabb_2d_t>                     _aabbs;
+    std::vector<uint8_t>                       _collider_levels;
+};
+
+/// @brief Linear BVH broad phase collision detection.
+/// Rebuilt from scratch every frame, which suits highly dynamic scenes where
+/// refitting a tree degrades.  Colliders get a 30 bit Morton (Z curve) code
+/// from their AABB center and are radix sorted by it.  An implicit binary
+/// tree is then built over the sorted array in a single bottom-up pass: node
+/// k of level l covers sorted leaves [k * 2^l, (k + 1) * 2^l), so there are
+/// no child pointers and traversal is cache friendly.  Code generation and
+/// the per leaf queries run on the worker pool.
+class LinearBvhBroadPhase : public BroadPhase {
+  public:
+    LinearBvhBroadPhase(CollisionSystem2dImpl &collision_system)
+        : BroadPhase(collision_system) {}
+
+    void generateCollisionPairs() override;
+
+    const std::vector<CollisionPair> &collisionPairs() const override {
+        return _collision_pairs;
+    }
+
+  private:
+    /// @brief A collider sorted by its Morton code
+    struct Leaf {
+        uint32_t code;
+        uint32_t collider;
+    };
+
+    /// @brief Interleave the lower 15 bits of x and y into a 30 bit code
+    static uint32_t mortonCode(uint32_t x, uint32_t y);
+
+    /// @brief Sort the leaves by Morton code (LSD radix sort, 3 x 10 bits)
+    void radixSort();
+
+    /// @brief Query the tree for the pairs of the sorted leaves [begin, end)
+    void queryLeaves(size_t begin, size_t end,
+                     std::vector<CollisionPair> &pairs) const;
+
+  private:
+    std::vector<CollisionPair> _collision_pairs;
+    std::vector<aabb_2d_t>     _aabbs;
+    std::vector<Leaf>          _leaves;
+    std::vector<Leaf>          _sort_buffer;
+
+    // the tree levels stored one after the other, level 0 being the leaves
+    std::vector<aabb_2d_t> _nodes;
+    std::vector<size_t>    _level_offsets;
+    std::vector<size_t>    _level_sizes;
+
+    // per thread pair buffers
+    std::vector<std::vector<CollisionPair>> _thread_pairs;
+};
+
+/// @brief Spatial hash broad phase collision detection.
+/// A uniform grid over unbounded coordinates for large, sparse worlds.  Only
+/// occupied cells are stored, in a fixed capacity open addressing (linear
+/// probing) table keyed by the integer cell coordinates.  The table and the
+/// entry arrays are reused across frames: the table only grows, and is
+/// cleared by visiting the occupied slots rather than reallocated.
+/// Colliders covering more than MAX_CELLS_PER_COLLIDER cells are kept out
+/// of the table and tested against every collider instead.
+class SpatialHashBroadPhase : public BroadPhase {
+  public:
+    SpatialHashBroadPhase(CollisionSystem2dImpl &collision_system,
+                          float                  cell_size)
+        : BroadPhase(collision_system), _cell_size(cell_size) {}
+
+    void generateCollisionPairs() override;
+
+    const std::vector<CollisionPair> &collisionPairs() const override {
+        return _collision_pairs;
+    }
+
+  private:
+    static constexpr int MAX_CELLS_PER_COLLIDER = 64;
+
+    /// @brief Inclusive range of cells covered by a collider
+    struct CellRange {
+        int mn_x, mn_y, mx_x, mx_y;
+    };
+
+    /// @brief An occupied cell.  A count of 0 marks an empty slot.
+    struct Slot {
+        int32_t  x, y;
+        uint32_t start;
+        uint32_t count;
+    };
+
+    /// @brief Cell coordinate of a position, clamped to +-2^30 cells so far
+    /// away colliders cannot overflow.  NaN maps to the lowest cell.
+    static int cellCoord(float p, float inv_cell_size);
+
+    /// @brief Hash the integer cell coordinates
+    static uint32_t hashCell(int32_t x, int32_t y);
+
+    /// @brief Find the slot of a cell inserting it if not in the table
+    /// @return the slot index
+    uint32_t findOrInsert(int32_t x, int32_t y);
+
+    /// @brief Generate the pairs owned by a range of occupied slots
+    /// @param begin first index into the occupied slots
+    /// @param end one past the last index
+    /// @param pairs output pairs
+    void generateSlotPairs(size_t begin, size_t end,
+                           std::vector<CollisionPair> &pairs) const;
+
+  private:
+    std::vector<CollisionPair> _collision_pairs;
+    float                      _cell_size = 50;
+
+    // hash table (power of two capacity) and the occupied slot indices in
+    // insertion order
+    std::vector<Slot>     _slots;
+    std::vector<uint32_t> _occupied;
+
+    // per frame storage, reused across frames
+    std::vector<aabb_2d_t> _aabbs;
+    std::vector<CellRange> _cell_ranges;
+    std::vector<uint32_t>  _oversized;
+    std::vector<uint32_t>  _entry_slots;
+    std::vector<uint32_t>  _cell_entries;
+
+    // per thread pair buffers
+    std::vector<std::vector<CollisionPair>> _thread_pairs;
 };
 
 } // namespace zo
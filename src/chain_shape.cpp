@@ -0,0 +1,71 @@
+#include "chain_shape.hpp"
+
+namespace zo {
+
+void ChainShape::setVertices(const std::vector<glm::vec2> &vertices,
+                             bool                          loop) {
+    _vertices = vertices;
+    _loop = loop;
+    build();
+}
+
+void ChainShape::setRadius(float radius) {
+    _radius = radius;
+    build();
+}
+
+void ChainShape::clear() {
+    _vertices.clear();
+    _nodes.clear();
+    _radius = 0.0f;
+    _loop = false;
+}
+
+aabb_2d_t ChainShape::bounds() const {
+    if (_nodes.empty()) {
+        return {glm::vec2(0), glm::vec2(0)};
+    }
+    return _nodes.front().aabb;
+}
+
+aabb_2d_t ChainShape::segmentAabb(uint32_t i) const {
+    const thick_line_segment_2d_t seg = segment(i);
+    const glm::vec2               thickness = {seg.radius, seg.radius};
+    return {glm::min(seg.line.start, seg.line.end) - thickness,
+            glm::max(seg.line.start, seg.line.end) + thickness};
+}
+
+void ChainShape::build() {
+    _nodes.clear();
+    const uint32_t num_segments = numSegments();
+    if (num_segments > 0) {
+        buildNode(0, num_segments);
+    }
+}
+
+uint32_t ChainShape::buildNode(uint32_t first, uint32_t count) {
+    const uint32_t node = uint32_t(_nodes.size());
+    _nodes.emplace_back();
+
+    aabb_2d_t bounds = segmentAabb(first);
+    for (uint32_t i = first + 1; i < first + count; i++) {
+        const aabb_2d_t aabb = segmentAabb(i);
+        bounds = {glm::min(bounds.mn, aabb.mn), glm::max(bounds.mx, aabb.mx)};
+    }
+    _nodes[node].aabb = bounds;
+    _nodes[node].first = first;
+    _nodes[node].count = count;
+
+    if (count <= LEAF_SIZE) {
+        return node;
+    }
+
+    // split the range of consecutive segments in half
+    const uint32_t half = count / 2;
+    buildNode(first, half);
+    const uint32_t right = buildNode(first + half, count - half);
+    _nodes[node].right = right;
+    return node;
+}
+
+} // namespace zo
@@ -0,0 +1,140 @@
+/**
+ * @file chain_shape.hpp
+ * @author Micah Pearlman (micahpearlman@gmail.com)
+ * @brief A thick polyline with a segment hierarchy.
+ * @version 0.1
+ * @date 2024-11-04
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#ifndef __zoPhysicsChainShape_h__
+#define __zoPhysicsChainShape_h__
+#include <zero_physics/types.hpp>
+#include <cstdint>
+#include <vector>
+
+namespace zo {
+
+/// @brief A thick polyline stored in one contiguous vertex array.
+/// Segment i runs from vertex i to vertex i + 1 (wrapping for loops).  A
+/// bounding volume hierarchy over ranges of consecutive segments is built
+/// when the vertices change; polylines are spatially coherent so ranges of
+/// consecutive segments make tight nodes without any sorting.
+/// See: polyline.hpp for the collision functions.
+class ChainShape {
+  public:
+    /// @brief Set the vertices
+    /// @param vertices the polyline vertices
+    /// @param loop true to close the polyline
+    void setVertices(const std::vector<glm::vec2> &vertices, bool loop);
+
+    /// @brief Set the thickness (radius) of the segments
+    void setRadius(float radius);
+
+    /// @brief Remove all vertices
+    void clear();
+
+    const std::vector<glm::vec2> &vertices() const { return _vertices; }
+    bool                          loop() const { return _loop; }
+    float                         radius() const { return _radius; }
+
+    /// @brief Number of segments
+    uint32_t numSegments() const {
+        const uint32_t n = uint32_t(_vertices.size());
+        return n < 2 ? 0 : (_loop && n > 2 ? n : n - 1);
+    }
+
+    /// @brief Get segment i
+    thick_line_segment_2d_t segment(uint32_t i) const {
+        return {{_vertices[i], _vertices[(i + 1) % _vertices.size()]},
+                _radius};
+    }
+
+    /// @brief Bounds of the whole chain (including the thickness)
+    aabb_2d_t bounds() const;
+
+    /// @brief Call callback(uint32_t segment) for every segment whose
+    /// bounds overlap aabb.
+    template <typename Callback>
+    void query(const aabb_2d_t &aabb, Callback &&callback) const {
+        if (_nodes.empty()) {
+            return;
+        }
+        // halving splits keep the depth at log2(N)
+        uint32_t stack[64];
+        int      top = 0;
+        stack[top++] = 0;
+        while (top > 0) {
+            const Node &node = _nodes[stack[--top]];
+            if (overlaps(node.aabb, aabb) == false) {
+                continue;
+            }
+            if (node.right == 0) {
+                for (uint32_t i = node.first; i < node.first + node.count;
+                     i++) {
+                    if (overlaps(segmentAabb(i), aabb)) {
+                        callback(i);
+                    }
+                }
+                continue;
+            }
+            // the left child directly follows its parent
+            stack[top++] = node.right;
+            stack[top++] = uint32_t(&node - _nodes.data()) + 1;
+        }
+    }
+
+    /// @brief Get the segment sharing the start (or end) vertex of segment i
+    /// @param i the segment
+    /// @param start true for the start vertex, false for the end vertex
+    /// @param j the neighboring segment
+    /// @return false if the vertex is an open end
+    bool neighbor(uint32_t i, bool start, uint32_t &j) const {
+        const uint32_t num_segments = numSegments();
+        const bool     wraps = _loop && num_segments > 2;
+        if (start) {
+            if (i == 0 && wraps == false) {
+                return false;
+            }
+            j = i > 0 ? i - 1 : num_segments - 1;
+            return true;
+        }
+        if (i + 1 == num_segments && wraps == false) {
+            return false;
+        }
+        j = (i + 1) % num_segments;
+        return true;
+    }
+
+  private:
+    static constexpr uint32_t LEAF_SIZE = 4;
+
+    struct Node {
+        aabb_2d_t aabb;
+        /// @brief first segment and segment count
+        uint32_t first = 0;
+        uint32_t count = 0;
+        /// @brief right child of an interior node, 0 for leaves
+        uint32_t right = 0;
+    };
+
+    static bool overlaps(const aabb_2d_t &a, const aabb_2d_t &b) {
+        return a.mn.x <= b.mx.x && b.mn.x <= a.mx.x && a.mn.y <= b.mx.y &&
+               b.mn.y <= a.mx.y;
+    }
+
+    aabb_2d_t segmentAabb(uint32_t i) const;
+
+    void     build();
+    uint32_t buildNode(uint32_t first, uint32_t count);
+
+  private:
+    std::vector<glm::vec2> _vertices;
+    std::vector<Node>      _nodes;
+    float                  _radius = 0.0f;
+    bool                   _loop = false;
+};
+
+} // namespace zo
+#endif // __zoPhysicsChainShape_h__
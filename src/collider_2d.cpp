@@ -11,6 +11,7 @@
 #include "collider_2d_impl.hpp"
 #include "collision_system_2d_impl.hpp"
 #include <zero_physics/types.hpp>
+#include <zero_physics/math.hpp>
 
 namespace zo {
 Collider2dImpl::Collider2dImpl(CollisionSystem2dImpl &collision_system,
@@ -38,6 +39,7 @@ float Collider2dImpl::restitution() const { return baseData().restitution; }
 void Collider2dImpl::setFilter(uint16_t categoryBits, uint16_t maskBits) {
     baseData().category_bits = categoryBits;
     baseData().mask_bits = maskBits;
+    system().filtersChanged();
 }
 
 void Collider2dImpl::getFilter(uint16_t &categoryBits,
@@ -93,6 +95,10 @@ void CircleCollider2dImpl::updateAabb() {
     const circle_2d_t &circle = data().circle;
     aabb.mn = circle.center - glm::vec2{circle.radius, circle.radius};
     aabb.mx = circle.center + glm::vec2{circle.radius, circle.radius};
+    data().sweep = glm::vec2(0); // placed, not moved
+    if (data().is_static) {
+        system().staticCollidersChanged();
+    }
 }
 
 circle_2d_t CircleCollider2dImpl::circle() const { return data().circle; }
@@ -156,8 +162,11 @@ void LineCollider2dImpl::updateAabb() {
     aabb_2d_t                     &aabb = data().aabb;
     const thick_line_segment_2d_t &line = data().line;
     const glm::vec2 thickness{line.radius, line.radius};
-    aabb.mn = glm::min(line.line.start-thickness, line.line.end+thickness);
-    aabb.mx = glm::max(line.line.start-thickness, line.line.end+thickness);
+    aabb.mn = glm::min(line.line.start, line.line.end) - thickness;
+    aabb.mx = glm::max(line.line.start, line.line.end) + thickness;
+    if (data().is_static) {
+        system().staticCollidersChanged();
+    }
 }
 
 Collider2dImpl::Data &LineCollider2dImpl::baseData() { return data(); }
@@ -166,4 +175,208 @@ const Collider2dImpl::Data &LineCollider2dImpl::baseData() const {
     return data();
 }
 
+/// BoxCollider2dImpl
+
+std::unique_ptr<BoxCollider2d>
+BoxCollider2d::create(CollisionSystem2d &collision_system) {
+    CollisionSystem2dImpl &sys =
+        dynamic_cast<CollisionSystem2dImpl &>(collision_system);
+    std::optional<collider_handle_2d_t> collider_handle =
+        sys.createCollider(ColliderType::BOX);
+    if (!collider_handle.has_value()) {
+        return nullptr;
+    }
+    return std::make_unique<BoxCollider2dImpl>(sys, collider_handle.value());
+}
+
+BoxCollider2dImpl::BoxCollider2dImpl(CollisionSystem2dImpl &collision_system,
+                                     collider_handle_2d_t   handle)
+    : Collider2dImpl(collision_system, handle),
+      _data{system().getColliderData<BoxCollider2dImpl::Data>(handle)} {}
+
+void BoxCollider2dImpl::setWidth(float width) {
+    data().box.half_extents.x = 0.5f * width;
+    updateAabb();
+}
+
+float BoxCollider2dImpl::width() const {
+    return 2.0f * data().box.half_extents.x;
+}
+
+void BoxCollider2dImpl::setHeight(float height) {
+    data().box.half_extents.y = 0.5f * height;
+    updateAabb();
+}
+
+float BoxCollider2dImpl::height() const {
+    return 2.0f * data().box.half_extents.y;
+}
+
+void BoxCollider2dImpl::setCenter(const glm::vec2 &center) {
+    data().box.center = center;
+    updateAabb();
+}
+
+glm::vec2 BoxCollider2dImpl::center() const { return data().box.center; }
+
+void BoxCollider2dImpl::setAngle(float angle) {
+    data().box.angle = angle;
+    updateAabb();
+}
+
+float BoxCollider2dImpl::angle() const { return data().box.angle; }
+
+void BoxCollider2dImpl::setBox(const box_2d_t &box) {
+    data().box = box;
+    updateAabb();
+}
+
+box_2d_t BoxCollider2dImpl::box() const { return data().box; }
+
+const aabb_2d_t &BoxCollider2dImpl::aabb() const { return data().aabb; }
+
+void BoxCollider2dImpl::updateAabb() {
+    data().aabb = boxAabb(data().box);
+    if (data().is_static) {
+        system().staticCollidersChanged();
+    }
+}
+
+Collider2dImpl::Data &BoxCollider2dImpl::baseData() { return data(); }
+
+const Collider2dImpl::Data &BoxCollider2dImpl::baseData() const {
+    return data();
+}
+
+/// ChainCollider2dImpl
+
+std::unique_ptr<ChainCollider2d>
+ChainCollider2d::create(CollisionSystem2d &collision_system) {
+    CollisionSystem2dImpl &sys =
+        dynamic_cast<CollisionSystem2dImpl &>(collision_system);
+    std::optional<collider_handle_2d_t> collider_handle =
+        sys.createCollider(ColliderType::CHAIN);
+    if (!collider_handle.has_value()) {
+        return nullptr;
+    }
+    return std::make_unique<ChainCollider2dImpl>(sys, collider_handle.value());
+}
+
+ChainCollider2dImpl::ChainCollider2dImpl(
+    CollisionSystem2dImpl &collision_system, collider_handle_2d_t handle)
+    : Collider2dImpl(collision_system, handle),
+      _data{system().getColliderData<ChainCollider2dImpl::Data>(handle)} {}
+
+void ChainCollider2dImpl::setVertices(const std::vector<glm::vec2> &vertices) {
+    data().shape->setVertices(vertices, data().shape->loop());
+    updateAabb();
+}
+
+const std::vector<glm::vec2> &ChainCollider2dImpl::vertices() const {
+    return data().shape->vertices();
+}
+
+void ChainCollider2dImpl::setLoop(bool loop) {
+    data().shape->setVertices(data().shape->vertices(), loop);
+    updateAabb();
+}
+
+bool ChainCollider2dImpl::isLoop() const { return data().shape->loop(); }
+
+void ChainCollider2dImpl::setThickness(float thickness) {
+    data().shape->setRadius(thickness);
+    updateAabb();
+}
+
+float ChainCollider2dImpl::thickness() const { return data().shape->radius(); }
+
+const aabb_2d_t &ChainCollider2dImpl::aabb() const { return data().aabb; }
+
+void ChainCollider2dImpl::updateAabb() {
+    data().aabb = data().shape->bounds();
+    if (data().is_static) {
+        system().staticCollidersChanged();
+    }
+}
+
+Collider2dImpl::Data &ChainCollider2dImpl::baseData() { return data(); }
+
+const Collider2dImpl::Data &ChainCollider2dImpl::baseData() const {
+    return data();
+}
+
+/// HeightfieldCollider2dImpl
+
+std::unique_ptr<HeightfieldCollider2d>
+HeightfieldCollider2d::create(CollisionSystem2d &collision_system) {
+    CollisionSystem2dImpl &sys =
+        dynamic_cast<CollisionSystem2dImpl &>(collision_system);
+    std::optional<collider_handle_2d_t> collider_handle =
+        sys.createCollider(ColliderType::HEIGHTFIELD);
+    if (!collider_handle.has_value()) {
+        return nullptr;
+    }
+    return std::make_unique<HeightfieldCollider2dImpl>(sys,
+                                                       collider_handle.value());
+}
+
+HeightfieldCollider2dImpl::HeightfieldCollider2dImpl(
+    CollisionSystem2dImpl &collision_system, collider_handle_2d_t handle)
+    : Collider2dImpl(collision_system, handle),
+      _data{system().getColliderData<HeightfieldCollider2dImpl::Data>(
+          handle)} {}
+
+void HeightfieldCollider2dImpl::setHeights(const std::vector<float> &heights) {
+    data().shape->setHeights(heights);
+    updateAabb();
+}
+
+const std::vector<float> &HeightfieldCollider2dImpl::heights() const {
+    return data().shape->heights();
+}
+
+void HeightfieldCollider2dImpl::setOrigin(const glm::vec2 &origin) {
+    data().shape->setOrigin(origin);
+    updateAabb();
+}
+
+glm::vec2 HeightfieldCollider2dImpl::origin() const {
+    return data().shape->origin();
+}
+
+void HeightfieldCollider2dImpl::setSpacing(float spacing) {
+    data().shape->setSpacing(spacing);
+    updateAabb();
+}
+
+float HeightfieldCollider2dImpl::spacing() const {
+    return data().shape->spacing();
+}
+
+void HeightfieldCollider2dImpl::setThickness(float thickness) {
+    data().shape->setRadius(thickness);
+    updateAabb();
+}
+
+float HeightfieldCollider2dImpl::thickness() const {
+    return data().shape->radius();
+}
+
+const aabb_2d_t &HeightfieldCollider2dImpl::aabb() const {
+    return data().aabb;
+}
+
+void HeightfieldCollider2dImpl::updateAabb() {
+    data().aabb = data().shape->bounds();
+    if (data().is_static) {
+        system().staticCollidersChanged();
+    }
+}
+
+Collider2dImpl::Data &HeightfieldCollider2dImpl::baseData() { return data(); }
+
+const Collider2dImpl::Data &HeightfieldCollider2dImpl::baseData() const {
+    return data();
+}
+
 } // namespace zo
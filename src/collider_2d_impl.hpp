@@ -14,6 +14,8 @@
 #include <zero_physics/collider_2d.hpp>
 #include <zero_physics/types.hpp>
 #include "types_impl.hpp"
+#include "chain_shape.hpp"
+#include "heightfield_shape.hpp"
 
 namespace zo {
 
@@ -24,11 +26,18 @@ class Collider2dImpl : virtual public Collider2d {
     struct alignas(std::max_align_t) Data {
         uint8_t   type = uint8_t(ColliderType::MAX);
         bool      is_sensor = false;
+        /// @brief static colliders (chains, heightfields and colliders the
+        /// physics system marks static) are kept out of the broad phase.
+        /// See: CollisionSystem2dImpl::setColliderStatic().
+        bool      is_static = false;
         float     friction = 0.0f;
         float     restitution = 0.83;
-        uint16_t  category_bits = 0;
-        uint16_t  mask_bits = 0;
+        uint16_t  category_bits = 0x0001;
+        uint16_t  mask_bits = 0xffff;
         aabb_2d_t aabb;
+        /// @brief displacement over the last step of a fast moving circle,
+        /// zero otherwise.  The aabb covers the whole sweep.
+        glm::vec2 sweep = {0, 0};
     };
 
     CollisionSystem2dImpl &_sys;
@@ -50,6 +59,13 @@ class Collider2dImpl : virtual public Collider2d {
 
     CollisionSystem2dImpl &system() { return _sys; }
 
+    /// @brief Collision filter.  Two colliders collide if each one's
+    /// category is in the other one's mask.
+    static bool shouldCollide(const Data &a, const Data &b) {
+        return (a.category_bits & b.mask_bits) != 0 &&
+               (b.category_bits & a.mask_bits) != 0;
+    }
+
   protected:
     virtual Collider2dImpl::Data       &baseData() = 0;
     virtual const Collider2dImpl::Data &baseData() const = 0;
@@ -137,5 +153,131 @@ class LineCollider2dImpl : public Collider2dImpl, public LineCollider2d {
   private:
     LineCollider2dImpl::Data &_data;
 };
+
+class BoxCollider2dImpl : public Collider2dImpl, public BoxCollider2d {
+  public:
+    struct alignas(std::max_align_t) Data : Collider2dImpl::Data {
+        box_2d_t box = {{0, 0}, {0.5f, 0.5f}, 0};
+    };
+
+  public:
+    BoxCollider2dImpl(CollisionSystem2dImpl &collision_system,
+                      collider_handle_2d_t   handle);
+    virtual ~BoxCollider2dImpl() = default;
+    void      setWidth(float width) override;
+    float     width() const override;
+    void      setHeight(float height) override;
+    float     height() const override;
+    void      setCenter(const glm::vec2 &center) override;
+    glm::vec2 center() const override;
+    void      setAngle(float angle) override;
+    float     angle() const override;
+    void      setBox(const box_2d_t &box) override;
+    box_2d_t  box() const override;
+
+    /// @brief Get the base collider data
+    /// @return Collider2dImpl::Data& base collider data
+    Collider2dImpl::Data       &baseData() override;
+    const Collider2dImpl::Data &baseData() const override;
+
+    /// @brief Update the axis aligned bounding box
+    void updateAabb();
+
+    const aabb_2d_t &aabb() const override;
+
+    /// @brief Get the box collider data
+    /// @return BoxCollider2dImpl::Data
+    BoxCollider2dImpl::Data &data() { return _data; }
+
+    /// @brief Get the box collider data
+    /// @return const BoxCollider2dImpl::Data
+    BoxCollider2dImpl::Data const &data() const { return _data; }
+
+  private:
+    BoxCollider2dImpl::Data &_data;
+};
+
+class ChainCollider2dImpl : public Collider2dImpl, public ChainCollider2d {
+  public:
+    struct alignas(std::max_align_t) Data : Collider2dImpl::Data {
+        /// @brief the polyline, owned by the collision system
+        ChainShape *shape = nullptr;
+    };
+
+  public:
+    ChainCollider2dImpl(CollisionSystem2dImpl &collision_system,
+                        collider_handle_2d_t   handle);
+    virtual ~ChainCollider2dImpl() = default;
+    void  setVertices(const std::vector<glm::vec2> &vertices) override;
+    const std::vector<glm::vec2> &vertices() const override;
+    void  setLoop(bool loop) override;
+    bool  isLoop() const override;
+    void  setThickness(float thickness) override;
+    float thickness() const override;
+
+    /// @brief Get the base collider data
+    /// @return Collider2dImpl::Data& base collider data
+    Collider2dImpl::Data       &baseData() override;
+    const Collider2dImpl::Data &baseData() const override;
+
+    /// @brief Update the axis aligned bounding box
+    void updateAabb();
+
+    const aabb_2d_t &aabb() const override;
+
+    /// @brief Get the chain collider data
+    /// @return ChainCollider2dImpl::Data
+    ChainCollider2dImpl::Data &data() { return _data; }
+
+    /// @brief Get the chain collider data
+    /// @return const ChainCollider2dImpl::Data
+    ChainCollider2dImpl::Data const &data() const { return _data; }
+
+  private:
+    ChainCollider2dImpl::Data &_data;
+};
+
+class HeightfieldCollider2dImpl : public Collider2dImpl,
+                                  public HeightfieldCollider2d {
+  public:
+    struct alignas(std::max_align_t) Data : Collider2dImpl::Data {
+        /// @brief the heightfield, owned by the collision system
+        HeightfieldShape *shape = nullptr;
+    };
+
+  public:
+    HeightfieldCollider2dImpl(CollisionSystem2dImpl &collision_system,
+                              collider_handle_2d_t   handle);
+    virtual ~HeightfieldCollider2dImpl() = default;
+    void      setHeights(const std::vector<float> &heights) override;
+    const std::vector<float> &heights() const override;
+    void      setOrigin(const glm::vec2 &origin) override;
+    glm::vec2 origin() const override;
+    void      setSpacing(float spacing) override;
+    float     spacing() const override;
+    void      setThickness(float thickness) override;
+    float     thickness() const override;
+
+    /// @brief Get the base collider data
+    /// @return Collider2dImpl::Data& base collider data
+    Collider2dImpl::Data       &baseData() override;
+    const Collider2dImpl::Data &baseData() const override;
+
+    /// @brief Update the axis aligned bounding box
+    void updateAabb();
+
+    const aabb_2d_t &aabb() const override;
+
+    /// @brief Get the heightfield collider data
+    /// @return HeightfieldCollider2dImpl::Data
+    HeightfieldCollider2dImpl::Data &data() { return _data; }
+
+    /// @brief Get the heightfield collider data
+    /// @return const HeightfieldCollider2dImpl::Data
+    HeightfieldCollider2dImpl::Data const &data() const { return _data; }
+
+  private:
+    HeightfieldCollider2dImpl::Data &_data;
+};
 } // namespace zo
 #endif // __zoPhysicsCollider2dImpl_h__
@@ -10,39 +10,194 @@
  */
 #include "physics_system_2d_impl.hpp"
 #include <zero_physics/math.hpp>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <utility>
 
 namespace zo {
 
 std::shared_ptr<CollisionSystem2d>
-CollisionSystem2d::create(size_t         max_colliders,
-                          BroadPhaseType broad_phase_type) {
-    return std::make_shared<CollisionSystem2dImpl>(max_colliders,
-                                                   broad_phase_type);
+CollisionSystem2d::create(size_t                      max_colliders,
+                          BroadPhaseType              broad_phase_type,
+                          const broad_phase_config_t &broad_phase_config,
+                          size_t                      num_threads) {
+    return std::make_shared<CollisionSystem2dImpl>(
+        max_colliders, broad_phase_type, broad_phase_config, num_threads);
 }
 
-CollisionSystem2dImpl::CollisionSystem2dImpl(size_t         max_colliders,
-                                             BroadPhaseType broad_phase_type)
-    : _circle_collider_pool(max_colliders) {
+CollisionSystem2dImpl::CollisionSystem2dImpl(
+    size_t max_colliders, BroadPhaseType broad_phase_type,
+    const broad_phase_config_t &broad_phase_config, size_t num_threads)
+    : _worker_pool(num_threads), _circle_collider_pool(max_colliders),
+      _box_collider_pool(max_colliders),
+      _chain_collider_pool(MAX_CHAIN_COLLIDERS),
+      _chain_shapes(MAX_CHAIN_COLLIDERS),
+      _heightfield_collider_pool(MAX_HEIGHTFIELD_COLLIDERS),
+      _heightfield_shapes(MAX_HEIGHTFIELD_COLLIDERS) {
 
     // make sure the max colliders cannot be greater then 28 bits
     if (max_colliders > (1 << 28)) {
         throw std::runtime_error("max_colliders must be less than 2^28");
     }
+    // also rejects NaN
+    if ((broad_phase_config.grid_size > 0) == false) {
+        throw std::runtime_error("grid_size must be greater than 0");
+    }
+
+    _broad_phase_config = broad_phase_config;
+    _broad_phase_stats.thresholds = broad_phase_config.auto_thresholds;
+    _broad_phase_stats.is_auto = broad_phase_type == BroadPhaseType::AUTO;
+    _broad_phase_stats.type = _broad_phase_stats.is_auto
+                                  ? BroadPhaseType::NAIVE
+                                  : broad_phase_type;
+    _broad_phase = createBroadPhase(_broad_phase_stats.type);
+}
 
+std::unique_ptr<BroadPhase>
+CollisionSystem2dImpl::createBroadPhase(BroadPhaseType broad_phase_type) {
+    const broad_phase_config_t &broad_phase_config = _broad_phase_config;
     switch (broad_phase_type) {
     case BroadPhaseType::NAIVE: {
-        _broad_phase = std::make_unique<NaiveBroadPhase>(*this);
-    } break;
+        return std::make_unique<NaiveBroadPhase>(*this);
+    }
     case BroadPhaseType::GRID: {
-        _broad_phase = std::make_unique<GridBroadPhase>(*this, 50); // HARDWIRED! TODO: make grid size configurable
-    } break;
+        return std::make_unique<GridBroadPhase>(
+            *this, broad_phase_config.grid_size,
+            broad_phase_config.world_bounds);
+    }
+    case BroadPhaseType::SWEEP_PRUNE: {
+        return std::make_unique<SweepAndPruneBroadPhase>(*this);
+    }
+    case BroadPhaseType::DYNAMIC_TREE: {
+        return std::make_unique<DynamicTreeBroadPhase>(*this);
+    }
+    case BroadPhaseType::VERLET_LIST: {
+        return std::make_unique<VerletListBroadPhase>(
+            *this, broad_phase_config.verlet_skin);
+    }
+    case BroadPhaseType::BRUTE_FORCE: {
+        return std::make_unique<BruteForceBroadPhase>(*this);
+    }
+    case BroadPhaseType::HIERARCHICAL_GRID: {
+        return std::make_unique<HierarchicalGridBroadPhase>(
+            *this, broad_phase_config.grid_size);
+    }
+    case BroadPhaseType::LINEAR_BVH: {
+        return std::make_unique<LinearBvhBroadPhase>(*this);
+    }
+    case BroadPhaseType::SPATIAL_HASH: {
+        return std::make_unique<SpatialHashBroadPhase>(
+            *this, broad_phase_config.grid_size);
+    }
     default:
-        throw std::runtime_error("Unsupported broad phase type");
         break;
     }
+    throw std::runtime_error("Unsupported broad phase type");
+}
+
+void CollisionSystem2dImpl::setBroadPhaseType(BroadPhaseType broad_phase_type) {
+    _broad_phase_stats.is_auto = broad_phase_type == BroadPhaseType::AUTO;
+    if (_broad_phase_stats.is_auto == false &&
+        broad_phase_type != _broad_phase_stats.type) {
+        switchBroadPhase(broad_phase_type);
+    }
+}
+
+void CollisionSystem2dImpl::switchBroadPhase(BroadPhaseType broad_phase_type) {
+    std::unique_ptr<BroadPhase> broad_phase =
+        createBroadPhase(broad_phase_type);
+    for (const ColliderHandle &hndl : _colliders) {
+        broad_phase->addCollider(hndl);
+    }
+    _broad_phase = std::move(broad_phase);
+    _broad_phase_stats.type = broad_phase_type;
+}
+
+void CollisionSystem2dImpl::sampleBroadPhase() {
+    broad_phase_stats_t                 &stats = _broad_phase_stats;
+    const broad_phase_auto_thresholds_t &thresholds = stats.thresholds;
+    stats.frame++;
+    if (stats.frame % std::max(thresholds.sample_interval, 1u) != 0) {
+        return;
+    }
+
+    // sample the collider count, size spread and pair to contact ratio
+    float min_extent = std::numeric_limits<float>::max();
+    float max_extent = 0;
+    for (const ColliderHandle &hndl : _colliders) {
+        const aabb_2d_t &aabb = getBaseColliderData(hndl).aabb;
+        const glm::vec2  size = aabb.mx - aabb.mn;
+        const float      extent = std::max(size.x, size.y);
+        min_extent = std::min(min_extent, extent);
+        max_extent = std::max(max_extent, extent);
+    }
+    stats.num_colliders = uint32_t(_colliders.size());
+    stats.size_spread =
+        _colliders.size() > 0 ? max_extent / std::max(min_extent, EPSILON)
+                              : 1.0f;
+    stats.pair_ratio =
+        float(_sample_pair_tests) / float(std::max<uint64_t>(_sample_contacts, 1));
+    _sample_pair_tests = 0;
+    _sample_contacts = 0;
+    if (stats.is_auto == false) {
+        return;
+    }
+
+    // thresholds only switch back once the sample falls back past them by
+    // the hysteresis
+    const BroadPhaseType current = stats.type;
+    const float          keep = 1.0f - thresholds.hysteresis;
+    const bool           few_colliders =
+        current == BroadPhaseType::NAIVE
+                      ? stats.num_colliders <= thresholds.naive_max_colliders
+                      : stats.num_colliders <= thresholds.naive_max_colliders * keep;
+    const bool mixed_sizes =
+        current == BroadPhaseType::DYNAMIC_TREE
+            ? stats.size_spread > thresholds.size_spread * keep
+            : stats.size_spread > thresholds.size_spread;
+
+    // the pair ratio can only be measured while on the grid.  Remember the
+    // grid was too coarse until the collider count changes significantly.
+    if (current == BroadPhaseType::GRID &&
+        stats.pair_ratio > thresholds.pair_ratio) {
+        _auto_coarse_grid_colliders = stats.num_colliders;
+    } else if (_auto_coarse_grid_colliders > 0 &&
+               std::abs(float(stats.num_colliders) -
+                        float(_auto_coarse_grid_colliders)) >
+                   thresholds.hysteresis * _auto_coarse_grid_colliders) {
+        _auto_coarse_grid_colliders = 0;
+    }
+
+    BroadPhaseType         target = BroadPhaseType::GRID;
+    BroadPhaseSwitchReason reason = BroadPhaseSwitchReason::SIZE_SPREAD;
+    if (few_colliders) {
+        target = BroadPhaseType::NAIVE;
+        reason = BroadPhaseSwitchReason::COLLIDER_COUNT;
+    } else if (mixed_sizes) {
+        target = BroadPhaseType::DYNAMIC_TREE;
+    } else if (_auto_coarse_grid_colliders > 0) {
+        target = BroadPhaseType::DYNAMIC_TREE;
+        reason = BroadPhaseSwitchReason::PAIR_RATIO;
+    }
+    if (current == BroadPhaseType::NAIVE) {
+        // leaving naive is always due to the collider count
+        reason = BroadPhaseSwitchReason::COLLIDER_COUNT;
+    }
+
+    if (target != current) {
+        switchBroadPhase(target);
+        stats.num_switches++;
+        stats.last_switch_frame = stats.frame;
+        stats.last_switch_reason = reason;
+    }
 }
 
 void CollisionSystem2dImpl::destroyCollider(collider_handle_2d_t hndl) {
+    if (removeCollider(hndl) == false) {
+        return; // already destroyed
+    }
+
     switch (hndl.type) {
     case uint8_t(ColliderType::CIRCLE): {
         _circle_collider_pool.deallocate(hndl.index);
@@ -50,6 +205,17 @@ void CollisionSystem2dImpl::destroyCollider(collider_handle_2d_t hndl) {
     case uint8_t(ColliderType::LINE): {
         _line_collider_pool.deallocate(hndl.index);
     } break;
+    case uint8_t(ColliderType::BOX): {
+        _box_collider_pool.deallocate(hndl.index);
+    } break;
+    case uint8_t(ColliderType::CHAIN): {
+        _chain_shapes[hndl.index].clear();
+        _chain_collider_pool.deallocate(hndl.index);
+    } break;
+    case uint8_t(ColliderType::HEIGHTFIELD): {
+        _heightfield_shapes[hndl.index].clear();
+        _heightfield_collider_pool.deallocate(hndl.index);
+    } break;
     default:
         break;
     }
@@ -71,7 +237,7 @@ CollisionSystem2dImpl::createCollider(ColliderType type) {
         collider_handle_2d_t hndl = {
             uint8_t(ColliderType::CIRCLE),
             uint32_t(_circle_collider_pool.ptrToIdx(data))};
-        _colliders.add(hndl);
+        addCollider(hndl);
         return hndl;
     } break;
     case ColliderType::LINE: {
@@ -82,7 +248,47 @@ CollisionSystem2dImpl::createCollider(ColliderType type) {
         collider_handle_2d_t hndl = {
             uint8_t(ColliderType::LINE),
             uint32_t(_line_collider_pool.ptrToIdx(data))};
-        _colliders.add(hndl);
+        addCollider(hndl);
+        return hndl;
+    } break;
+    case ColliderType::BOX: {
+        BoxCollider2dImpl::Data *data = _box_collider_pool.allocate();
+        if (data == nullptr) {
+            return std::nullopt;
+        }
+        collider_handle_2d_t hndl = {
+            uint8_t(ColliderType::BOX),
+            uint32_t(_box_collider_pool.ptrToIdx(data))};
+        addCollider(hndl);
+        return hndl;
+    } break;
+    case ColliderType::CHAIN: {
+        ChainCollider2dImpl::Data *data = _chain_collider_pool.allocate();
+        if (data == nullptr) {
+            return std::nullopt;
+        }
+        collider_handle_2d_t hndl = {
+            uint8_t(ColliderType::CHAIN),
+            uint32_t(_chain_collider_pool.ptrToIdx(data))};
+        data->shape = &_chain_shapes[hndl.index];
+        data->aabb = data->shape->bounds();
+        data->is_static = true;
+        addCollider(hndl);
+        return hndl;
+    } break;
+    case ColliderType::HEIGHTFIELD: {
+        HeightfieldCollider2dImpl::Data *data =
+            _heightfield_collider_pool.allocate();
+        if (data == nullptr) {
+            return std::nullopt;
+        }
+        collider_handle_2d_t hndl = {
+            uint8_t(ColliderType::HEIGHTFIELD),
+            uint32_t(_heightfield_collider_pool.ptrToIdx(data))};
+        data->shape = &_heightfield_shapes[hndl.index];
+        data->aabb = data->shape->bounds();
+        data->is_static = true;
+        addCollider(hndl);
         return hndl;
     } break;
 
@@ -93,6 +299,46 @@ CollisionSystem2dImpl::createCollider(ColliderType type) {
     return std::nullopt;
 }
 
+void CollisionSystem2dImpl::addCollider(const collider_handle_2d_t &hndl) {
+    if (getBaseColliderData(hndl).is_static) {
+        _collider_store_handles[hndl.handle] = _static_colliders.add(hndl);
+        _static_dirty = true;
+    } else {
+        _collider_store_handles[hndl.handle] = _colliders.add(hndl);
+        _broad_phase->addCollider(hndl);
+    }
+}
+
+bool CollisionSystem2dImpl::removeCollider(const collider_handle_2d_t &hndl) {
+    auto store_hndl = _collider_store_handles.find(hndl.handle);
+    if (store_hndl == _collider_store_handles.end()) {
+        return false;
+    }
+    if (getBaseColliderData(hndl).is_static) {
+        _static_colliders.remove(store_hndl->second);
+        _static_dirty = true;
+    } else {
+        _broad_phase->removeCollider(hndl);
+        _colliders.remove(store_hndl->second);
+    }
+    _collider_store_handles.erase(store_hndl);
+    return true;
+}
+
+void CollisionSystem2dImpl::setColliderStatic(const collider_handle_2d_t &hndl,
+                                              bool is_static) {
+    Collider2dImpl::Data &data = getBaseColliderData(hndl);
+    if (data.is_static == is_static) {
+        return;
+    }
+    if (removeCollider(hndl) == false) {
+        data.is_static = is_static;
+        return; // not registered (destroyed)
+    }
+    data.is_static = is_static;
+    addCollider(hndl);
+}
+
 const Collider2dImpl::Data &CollisionSystem2dImpl::getBaseColliderData(
     const collider_handle_2d_t &hndl) const {
     switch (hndl.type) {
@@ -102,60 +348,191 @@ const Collider2dImpl::Data &CollisionSystem2dImpl::getBaseColliderData(
     case uint8_t(ColliderType::LINE): {
         return getColliderData<LineCollider2dImpl::Data>(hndl);
     } break;
+    case uint8_t(ColliderType::BOX): {
+        return getColliderData<BoxCollider2dImpl::Data>(hndl);
+    } break;
+    case uint8_t(ColliderType::CHAIN): {
+        return getColliderData<ChainCollider2dImpl::Data>(hndl);
+    } break;
+    case uint8_t(ColliderType::HEIGHTFIELD): {
+        return getColliderData<HeightfieldCollider2dImpl::Data>(hndl);
+    } break;
     default:
         break;
     }
     throw std::runtime_error("Unsupported collider type");
 }
 
+Collider2dImpl::Data &
+CollisionSystem2dImpl::getBaseColliderData(const collider_handle_2d_t &hndl) {
+    return const_cast<Collider2dImpl::Data &>(
+        std::as_const(*this).getBaseColliderData(hndl));
+}
+
 void CollisionSystem2dImpl::generateCollisionPairs() {
     // clear the collision pairs
     _collision_pairs.clear();
+    _sensor_pairs.clear();
+
+    // dynamic vs dynamic pairs
+    sampleBroadPhase();
     _broad_phase->generateCollisionPairs();
 
-    // get the broad phase collision pairs
-    const std::vector<CollisionPair> &pairs = _broad_phase->collisionPairs();
+    // dynamic vs static pairs.  The static tree is only rebuilt when the
+    // static set changed and static vs static pairs are never generated.
+    if (_static_dirty) {
+        _static_tree.build(*this, _static_colliders);
+        _static_dirty = false;
+    }
+    _static_pairs.clear();
+    if (_static_tree.empty() == false) {
+        for (const ColliderHandle &hndl : _colliders) {
+            const aabb_2d_t &aabb = getBaseColliderData(hndl).aabb;
+            _static_tree.query(aabb, [&](const ColliderHandle &static_hndl) {
+                if (shouldCollide(hndl, static_hndl) == false) {
+                    return;
+                }
+                CollisionPair pair;
+                pair.a = hndl;
+                pair.b = static_hndl;
+                _static_pairs.push_back(pair);
+            });
+        }
+    }
 
     // do narrow phase collision detection
-    for (const CollisionPair &pair : pairs) {
-        contact_2d_t contact = {};
+    narrowPhase(_broad_phase->collisionPairs());
+    _sample_pair_tests += _broad_phase->collisionPairs().size();
+    _sample_contacts += _collision_pairs.size();
+    narrowPhase(_static_pairs);
+    sortSensorKeys();
+}
+
+void CollisionSystem2dImpl::updateCollisionPairs() {
+    _collision_pairs.clear();
+    _sensor_pairs.clear();
+    narrowPhase(_broad_phase->collisionPairs());
+    narrowPhase(_static_pairs);
+    sortSensorKeys();
+}
+
+bool CollisionSystem2dImpl::sensorOverlaps(const Collider2d &a,
+                                           const Collider2d &b) const {
+    CollisionPair pair;
+    pair.a = a.handle();
+    pair.b = b.handle();
+    return std::binary_search(_sensor_keys.begin(), _sensor_keys.end(),
+                              pair.key());
+}
+
+void CollisionSystem2dImpl::sortSensorKeys() {
+    _sensor_keys.clear();
+    for (const CollisionPair &pair : _sensor_pairs) {
+        _sensor_keys.push_back(pair.key());
+    }
+    std::sort(_sensor_keys.begin(), _sensor_keys.end());
+}
 
+void CollisionSystem2dImpl::narrowPhase(
+    const std::vector<CollisionPair> &pairs) {
+    // every pair gets a result slot so the chunks can run in parallel and
+    // the compaction below keeps the single threaded order
+    _narrow_phase_results.resize(pairs.size());
+    _narrow_phase_workers.resize(_worker_pool.numThreads());
+    _worker_pool.parallelFor(pairs.size(), [&](size_t begin, size_t end,
+                                               size_t worker) {
+        narrowPhaseChunk(pairs, begin, end, _narrow_phase_workers[worker]);
+    });
+
+    // compact the results in broad phase order
+    for (const NarrowPhaseResult &result : _narrow_phase_results) {
+        if (result.kind == NarrowPhaseResult::CONTACT) {
+            _collision_pairs.push_back(result.pair);
+        } else if (result.kind == NarrowPhaseResult::SENSOR) {
+            _sensor_pairs.push_back(result.pair);
+        }
+    }
+}
+
+void CollisionSystem2dImpl::narrowPhaseChunk(
+    const std::vector<CollisionPair> &pairs, size_t begin, size_t end,
+    NarrowPhaseWorker &worker) {
+    static constexpr auto NARROW_PHASE_BUCKETS = makeNarrowPhaseBuckets(
+        std::make_index_sequence<NUM_COLLIDER_TYPE_PAIRS>{});
+
+    // put each pair in canonical order once, in its result slot, and bucket
+    // it by collider types.  Circle vs circle pairs that need no special
+    // handling (sensors, sweeps) go into the batch instead.
+    worker.circle_batch.clear();
+    worker.circle_slots.clear();
+    for (std::vector<uint32_t> &bucket : worker.buckets) {
+        bucket.clear();
+    }
+    for (size_t i = begin; i < end; i++) {
+        NarrowPhaseResult &result = _narrow_phase_results[i];
+        result.kind = NarrowPhaseResult::NONE;
+        result.pair = canonicalPair(pairs[i]);
+        const CollisionPair &pair = result.pair;
         if (pair.a.type == uint8_t(ColliderType::CIRCLE) &&
             pair.b.type == uint8_t(ColliderType::CIRCLE)) {
             const auto &c1_data =
                 getColliderData<CircleCollider2dImpl::Data>(pair.a);
             const auto &c2_data =
                 getColliderData<CircleCollider2dImpl::Data>(pair.b);
-
-            if (circleToCircle(c1_data.circle, c2_data.circle, contact)) {
-                _collision_pairs.emplace_back(pair);
-                _collision_pairs.back().contact = contact;
+            if (c1_data.is_sensor == false && c2_data.is_sensor == false &&
+                c1_data.sweep == glm::vec2(0) && c2_data.sweep == glm::vec2(0)) {
+                worker.circle_batch.add(c1_data.circle, c2_data.circle);
+                worker.circle_slots.push_back(uint32_t(i));
+                continue;
             }
-        } else if (pair.a.type == uint8_t(ColliderType::CIRCLE) &&
-                   pair.b.type == uint8_t(ColliderType::LINE)) {
-            const auto &c1_data =
-                getColliderData<CircleCollider2dImpl::Data>(pair.a);
-            const auto &c2_data =
-                getColliderData<LineCollider2dImpl::Data>(pair.b);
-            if (circleToThickLineSegment(c1_data.circle, c2_data.line, contact)) {
-                _collision_pairs.emplace_back(pair);                
-                _collision_pairs.back().contact = contact;
-            }
-        } else if (pair.a.type == uint8_t(ColliderType::LINE) &&
-                   pair.b.type == uint8_t(ColliderType::CIRCLE)) {
-            const auto &c1_data =
-                getColliderData<LineCollider2dImpl::Data>(pair.a);
-            const auto &c2_data =
-                getColliderData<CircleCollider2dImpl::Data>(pair.b);
+        }
+        worker.buckets[colliderTypePair(pair)].push_back(uint32_t(i));
+    }
+
+    worker.circle_batch.collide();
+    for (size_t k = 0; k < worker.circle_slots.size(); k++) {
+        if (worker.circle_batch.hit(k)) {
+            NarrowPhaseResult &result =
+                _narrow_phase_results[worker.circle_slots[k]];
+            result.kind = NarrowPhaseResult::CONTACT;
+            result.pair.contact = worker.circle_batch.contact(k);
+        }
+    }
+
+    // one dispatch per bucket.  Combinations without a kernel never
+    // collide.
+    for (size_t t = 0; t < NUM_COLLIDER_TYPE_PAIRS; t++) {
+        if (worker.buckets[t].empty() == false &&
+            NARROW_PHASE_BUCKETS[t] != nullptr) {
+            (this->*NARROW_PHASE_BUCKETS[t])(worker.buckets[t]);
+        }
+    }
+}
+
+template <ColliderType A, ColliderType B>
+void CollisionSystem2dImpl::narrowPhaseBucket(
+    const std::vector<uint32_t> &slots) {
+    using DataA = typename ColliderDataOf<A>::type;
+    using DataB = typename ColliderDataOf<B>::type;
+    for (uint32_t slot : slots) {
+        NarrowPhaseResult &result = _narrow_phase_results[slot];
+        const DataA       &a = getColliderData<DataA>(result.pair.a);
+        const DataB       &b = getColliderData<DataB>(result.pair.b);
 
-            // NOTE: circle to line segment can only do circle to line ordering
-            // in this case we need to flip the order from A to B to B to A
-            // this preserves the collision normal
-            if (circleToThickLineSegment(c2_data.circle, c1_data.line, contact)) {
-                CollisionPair pair_flip = {pair.b, pair.a, contact};
-                _collision_pairs.emplace_back(pair_flip);
-                _collision_pairs.back().contact = contact;
+        // sensors only report overlaps, they never generate contacts
+        if (a.is_sensor || b.is_sensor) {
+            if (NarrowPhaseKernel<A, B>::overlaps(a, b)) {
+                result.kind = NarrowPhaseResult::SENSOR;
             }
+            continue;
+        }
+
+        contact_2d_t contact = {};
+        float        toi = 1.0f;
+        if (NarrowPhaseKernel<A, B>::collide(a, b, contact, toi)) {
+            result.kind = NarrowPhaseResult::CONTACT;
+            result.pair.contact = contact;
+            result.pair.toi = toi;
         }
     }
 }
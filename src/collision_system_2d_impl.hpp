@@ -16,14 +16,25 @@
 #include "collider_2d_impl.hpp"
 #include "types_impl.hpp"
 #include "broad_phase.hpp"
+#include "narrow_phase.hpp"
+#include "worker_pool.hpp"
+#include <array>
 #include <optional>
+#include <utility>
 #include <vector>
 
 namespace zo {
 
 class CollisionSystem2dImpl : public CollisionSystem2d {
   public:
-    CollisionSystem2dImpl(size_t max_colliders, BroadPhaseType broad_phase_type);
+    /// @brief chain and heightfield colliders are few and large (whole
+    /// polylines)
+    static constexpr size_t MAX_CHAIN_COLLIDERS = 1024;
+    static constexpr size_t MAX_HEIGHTFIELD_COLLIDERS = 1024;
+
+    CollisionSystem2dImpl(size_t max_colliders, BroadPhaseType broad_phase_type,
+                          const broad_phase_config_t &broad_phase_config,
+                          size_t                      num_threads = 1);
     ~CollisionSystem2dImpl() = default;
 
     void destroyCollider(collider_handle_2d_t hndl) override;
@@ -34,8 +45,10 @@ class CollisionSystem2dImpl : public CollisionSystem2d {
     /// @return
     std::optional<collider_handle_2d_t> createCollider(ColliderType type);
 
-    /// @brief Get specialized collider data (CircleCollider2dImpl::Data or
-    /// LineCollider2dImpl::Data) from the collider handle.
+    /// @brief Get specialized collider data (CircleCollider2dImpl::Data,
+    /// LineCollider2dImpl::Data, BoxCollider2dImpl::Data,
+    /// ChainCollider2dImpl::Data or HeightfieldCollider2dImpl::Data) from the
+    /// collider handle.
     /// @tparam T
     /// @param hndl the collider handle
     /// @return The collider data
@@ -44,15 +57,28 @@ class CollisionSystem2dImpl : public CollisionSystem2d {
             return _circle_collider_pool[hndl.index];
         } else if constexpr (std::is_same_v<T, LineCollider2dImpl::Data>) {
             return _line_collider_pool[hndl.index];
+        } else if constexpr (std::is_same_v<T, BoxCollider2dImpl::Data>) {
+            return _box_collider_pool[hndl.index];
+        } else if constexpr (std::is_same_v<T, ChainCollider2dImpl::Data>) {
+            return _chain_collider_pool[hndl.index];
+        } else if constexpr (std::is_same_v<T,
+                                            HeightfieldCollider2dImpl::Data>) {
+            return _heightfield_collider_pool[hndl.index];
         } else {
             static_assert(std::is_same_v<T, CircleCollider2dImpl::Data> ||
-                              std::is_same_v<T, LineCollider2dImpl::Data>,
+                              std::is_same_v<T, LineCollider2dImpl::Data> ||
+                              std::is_same_v<T, BoxCollider2dImpl::Data> ||
+                              std::is_same_v<T, ChainCollider2dImpl::Data> ||
+                              std::is_same_v<T,
+                                             HeightfieldCollider2dImpl::Data>,
                           "Invalid collider type");
         }
     }
 
-    /// @brief Get specialized collider data (CircleCollider2dImpl::Data or
-    /// LineCollider2dImpl::Data) from the collider handle.
+    /// @brief Get specialized collider data (CircleCollider2dImpl::Data,
+    /// LineCollider2dImpl::Data, BoxCollider2dImpl::Data,
+    /// ChainCollider2dImpl::Data or HeightfieldCollider2dImpl::Data) from the
+    /// collider handle.
     /// @tparam T
     /// @param hndl the collider handle
     /// @return The collider data
@@ -62,38 +88,236 @@ class CollisionSystem2dImpl : public CollisionSystem2d {
             return _circle_collider_pool[hndl.index];
         } else if constexpr (std::is_same_v<T, LineCollider2dImpl::Data>) {
             return _line_collider_pool[hndl.index];
+        } else if constexpr (std::is_same_v<T, BoxCollider2dImpl::Data>) {
+            return _box_collider_pool[hndl.index];
+        } else if constexpr (std::is_same_v<T, ChainCollider2dImpl::Data>) {
+            return _chain_collider_pool[hndl.index];
+        } else if constexpr (std::is_same_v<T,
+                                            HeightfieldCollider2dImpl::Data>) {
+            return _heightfield_collider_pool[hndl.index];
         } else {
             static_assert(std::is_same_v<T, CircleCollider2dImpl::Data> ||
-                              std::is_same_v<T, LineCollider2dImpl::Data>,
+                              std::is_same_v<T, LineCollider2dImpl::Data> ||
+                              std::is_same_v<T, BoxCollider2dImpl::Data> ||
+                              std::is_same_v<T, ChainCollider2dImpl::Data> ||
+                              std::is_same_v<T,
+                                             HeightfieldCollider2dImpl::Data>,
                           "Invalid collider type");
         }
     }
 
     const Collider2dImpl::Data &
     getBaseColliderData(const collider_handle_2d_t &hndl) const;
+    Collider2dImpl::Data &getBaseColliderData(const collider_handle_2d_t &hndl);
 
     void generateCollisionPairs() override;
 
+    /// @brief Narrow phase the broad phase pairs of the last
+    /// generateCollisionPairs() again.  Only valid while the colliders stay
+    /// inside the aabbs they had then, e.g., when the aabbs were inflated by
+    /// the motion of the following physics sub-steps.
+    void updateCollisionPairs();
+
+    void setBroadPhaseType(BroadPhaseType broad_phase_type) override;
+
+    const broad_phase_stats_t &broadPhaseStats() const override {
+        return _broad_phase_stats;
+    }
+
     /// @brief Get the collision pairs
     /// @return
     const std::vector<CollisionPair> &collisionPairs() const {
         return _collision_pairs;
     }
 
-    /// @brief Get the collider store
+    /// @brief Get the overlapping pairs involving a sensor.  These have no
+    /// contact information and are not resolved by the physics system.
+    /// @return
+    const std::vector<CollisionPair> &sensorPairs() const {
+        return _sensor_pairs;
+    }
+
+    size_t numSensorOverlaps() const override { return _sensor_pairs.size(); }
+
+    bool sensorOverlaps(const Collider2d &a,
+                        const Collider2d &b) const override;
+
+    /// @brief Check the category and mask bits of two colliders.
+    /// @return true if the colliders are allowed to collide
+    bool shouldCollide(const collider_handle_2d_t &a,
+                       const collider_handle_2d_t &b) const {
+        return Collider2dImpl::shouldCollide(getBaseColliderData(a),
+                                             getBaseColliderData(b));
+    }
+
+    /// @brief Notify that a collider filter changed.  Broad phases that
+    /// cache pairs compare the revision to know when to rebuild.
+    void filtersChanged() { _filter_revision++; }
+
+    /// @brief The collider filter revision
+    uint32_t filterRevision() const { return _filter_revision; }
+
+    /// @brief Get the dynamic collider store.  These are the colliders the
+    /// broad phase works on.
     /// @return const ComponentStore<ColliderHandle>& the collider store
     const ComponentStore<ColliderHandle> &colliders() const {
         return _colliders;
     }
 
+    /// @brief Get the static collider store
+    /// @return const ComponentStore<ColliderHandle>& the collider store
+    const ComponentStore<ColliderHandle> &staticColliders() const {
+        return _static_colliders;
+    }
+
+    /// @brief Get the worker pool shared by the collision and physics
+    /// systems
+    /// @return WorkerPool& the worker pool
+    WorkerPool &workerPool() { return _worker_pool; }
+
+    /// @brief Mark a collider as static or dynamic.  Static colliders are
+    /// kept in a separate tree that is only rebuilt when the static set
+    /// changes and are never paired with each other.  Colliders are
+    /// dynamic until marked static (chains and heightfields are always
+    /// static), so a collision system without a physics system pairs all
+    /// its colliders.
+    /// @param hndl the collider handle
+    /// @param is_static true if the collider does not move
+    void setColliderStatic(const collider_handle_2d_t &hndl, bool is_static);
+
+    /// @brief Notify that a static collider was added, removed or changed
+    void staticCollidersChanged() { _static_dirty = true; }
+
+  private:
+    /// @brief Create a broad phase implementation
+    /// @param broad_phase_type the broad phase type (not AUTO)
+    /// @return the broad phase
+    std::unique_ptr<BroadPhase> createBroadPhase(BroadPhaseType broad_phase_type);
+
+    /// @brief Replace the broad phase and move the dynamic colliders into it
+    /// @param broad_phase_type the broad phase type (not AUTO)
+    void switchBroadPhase(BroadPhaseType broad_phase_type);
+
+    /// @brief Sample the broad phase statistics and, if AUTO, switch to the
+    /// implementation best suited to the sample.
+    void sampleBroadPhase();
+
+    /// @brief Register a collider with the static or dynamic collider store.
+    /// Dynamic colliders are also added to the broad phase.
+    /// @param hndl the collider handle
+    void addCollider(const collider_handle_2d_t &hndl);
+
+    /// @brief Remove a collider from its collider store (and broad phase).
+    /// @param hndl the collider handle
+    /// @return false if the collider was not registered
+    bool removeCollider(const collider_handle_2d_t &hndl);
+
+    /// @brief Result of narrow phasing one broad phase pair
+    struct NarrowPhaseResult {
+        enum Kind : uint8_t { NONE, CONTACT, SENSOR };
+        Kind          kind = NONE;
+        CollisionPair pair;
+    };
+
+    /// @brief Narrow phase scratch of a worker
+    struct NarrowPhaseWorker {
+        CircleCircleBatch circle_batch;
+        // result slot of each pair in the circle batch
+        std::vector<uint32_t> circle_slots;
+        // result slots of the other pairs bucketed by colliderTypePair()
+        std::array<std::vector<uint32_t>, NUM_COLLIDER_TYPE_PAIRS> buckets;
+    };
+
+    /// @brief Narrow phase a list of broad phase pairs in parallel,
+    /// appending the collision and sensor pairs in the order of the broad
+    /// phase pairs (independent of the number of threads).
+    /// @param pairs the broad phase pairs
+    void narrowPhase(const std::vector<CollisionPair> &pairs);
+
+    /// @brief Sort the keys of the sensor pairs for sensorOverlaps()
+    void sortSensorKeys();
+
+    /// @brief Narrow phase a chunk of broad phase pairs into their result
+    /// slots.  Circle vs circle pairs are collided in a batch, the rest a
+    /// bucket of the same collider types at a time.
+    /// @param pairs the broad phase pairs
+    /// @param begin first pair of the chunk
+    /// @param end one past the last pair of the chunk
+    /// @param worker the worker's scratch
+    void narrowPhaseChunk(const std::vector<CollisionPair> &pairs, size_t begin,
+                          size_t end, NarrowPhaseWorker &worker);
+
+    /// @brief Narrow phase a bucket of canonical pairs of collider types A
+    /// and B in their result slots.  The kernel is called directly.
+    /// @param slots the result slots of the pairs
+    template <ColliderType A, ColliderType B>
+    void narrowPhaseBucket(const std::vector<uint32_t> &slots);
+
+    using NarrowPhaseBucketFn =
+        void (CollisionSystem2dImpl::*)(const std::vector<uint32_t> &);
+
+    /// @brief Get the bucket function of a colliderTypePair() index,
+    /// nullptr for combinations that never collide
+    template <size_t I>
+    static constexpr NarrowPhaseBucketFn narrowPhaseBucketFn() {
+        constexpr ColliderType A = ColliderType(I / size_t(ColliderType::MAX));
+        constexpr ColliderType B = ColliderType(I % size_t(ColliderType::MAX));
+        if constexpr (A <= B && NarrowPhaseKernel<A, B>::supported) {
+            return &CollisionSystem2dImpl::narrowPhaseBucket<A, B>;
+        } else {
+            return nullptr;
+        }
+    }
+
+    /// @brief Make the colliderTypePair() x bucket function table
+    template <size_t... I>
+    static constexpr std::array<NarrowPhaseBucketFn, sizeof...(I)>
+    makeNarrowPhaseBuckets(std::index_sequence<I...>) {
+        return {narrowPhaseBucketFn<I>()...};
+    }
+
   private:
+    WorkerPool                             _worker_pool;
     MemoryPool<CircleCollider2dImpl::Data> _circle_collider_pool;
     MemoryPool<LineCollider2dImpl::Data>   _line_collider_pool;
+    MemoryPool<BoxCollider2dImpl::Data>    _box_collider_pool;
+    MemoryPool<ChainCollider2dImpl::Data>  _chain_collider_pool;
+    // the polyline of each chain collider pool slot.  Never resized, so the
+    // chain collider data can point into it.
+    std::vector<ChainShape>                _chain_shapes;
+    MemoryPool<HeightfieldCollider2dImpl::Data> _heightfield_collider_pool;
+    std::vector<HeightfieldShape>               _heightfield_shapes;
     ComponentStore<ColliderHandle>         _colliders;
+    ComponentStore<ColliderHandle>         _static_colliders;
+    StaticColliderTree                     _static_tree;
+    bool                                   _static_dirty = true;
+    std::vector<CollisionPair>             _static_pairs;
+
+    // map collider handle to its handle in the (static) collider store
+    std::unordered_map<uint32_t, ComponentStore<ColliderHandle>::handle_t>
+        _collider_store_handles;
 
     std::unique_ptr<BroadPhase> _broad_phase = nullptr;
+    broad_phase_config_t        _broad_phase_config;
+    broad_phase_stats_t         _broad_phase_stats;
+
+    // accumulated since the last sample
+    uint64_t _sample_pair_tests = 0;
+    uint64_t _sample_contacts = 0;
+
+    // collider count when the grid was last measured too coarse, 0 if not
+    uint32_t _auto_coarse_grid_colliders = 0;
 
     std::vector<CollisionPair> _collision_pairs;
+    std::vector<CollisionPair> _sensor_pairs;
+    // sorted CollisionPair::key() of the sensor pairs
+    std::vector<uint64_t> _sensor_keys;
+
+    // narrow phase result slot of each broad phase pair, holding the pair
+    // in canonical order until it is narrow phased, and a scratch per worker
+    std::vector<NarrowPhaseResult> _narrow_phase_results;
+    std::vector<NarrowPhaseWorker> _narrow_phase_workers;
+    uint32_t                   _filter_revision = 0;
 };
 
 } // namespace zo
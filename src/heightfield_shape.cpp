@@ -0,0 +1,52 @@
+#include "heightfield_shape.hpp"
+#include <stdexcept>
+
+namespace zo {
+
+void HeightfieldShape::setHeights(const std::vector<float> &heights) {
+    _heights = heights;
+    updateBounds();
+}
+
+void HeightfieldShape::setOrigin(const glm::vec2 &origin) {
+    _origin = origin;
+    updateBounds();
+}
+
+void HeightfieldShape::setSpacing(float spacing) {
+    if (spacing <= 0) {
+        throw std::runtime_error("heightfield spacing must be positive");
+    }
+    _spacing = spacing;
+    updateBounds();
+}
+
+void HeightfieldShape::setRadius(float radius) {
+    _radius = radius;
+    updateBounds();
+}
+
+void HeightfieldShape::clear() {
+    _heights.clear();
+    _origin = {0, 0};
+    _spacing = 1.0f;
+    _radius = 0.0f;
+    _bounds = {glm::vec2(0), glm::vec2(0)};
+}
+
+aabb_2d_t HeightfieldShape::bounds() const { return _bounds; }
+
+void HeightfieldShape::updateBounds() {
+    if (_heights.empty()) {
+        _bounds = {_origin, _origin};
+        return;
+    }
+    const auto [mn, mx] = std::minmax_element(_heights.begin(), _heights.end());
+    const glm::vec2 thickness = {_radius, _radius};
+    _bounds.mn = glm::vec2(_origin.x, _origin.y + *mn) - thickness;
+    _bounds.mx = glm::vec2(_origin.x + float(numSegments()) * _spacing,
+                           _origin.y + *mx) +
+                 thickness;
+}
+
+} // namespace zo
@@ -0,0 +1,121 @@
+/**
+ * @file heightfield_shape.hpp
+ * @author Micah Pearlman (micahpearlman@gmail.com)
+ * @brief A thick heightfield with constant time column lookup.
+ * @version 0.1
+ * @date 2024-11-06
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#ifndef __zoPhysicsHeightfieldShape_h__
+#define __zoPhysicsHeightfieldShape_h__
+#include <zero_physics/types.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+namespace zo {
+
+/// @brief A thick heightfield.  Vertex i is at
+/// origin + (i * spacing, heights[i]) and column (segment) i runs from
+/// vertex i to vertex i + 1.  The columns under an AABB are found by
+/// indexing, so a query costs O(columns under the AABB) regardless of the
+/// heightfield size.  See: polyline.hpp for the collision functions.
+class HeightfieldShape {
+  public:
+    /// @brief Set the heights
+    void setHeights(const std::vector<float> &heights);
+
+    /// @brief Set the position of vertex 0
+    void setOrigin(const glm::vec2 &origin);
+
+    /// @brief Set the horizontal distance between vertices
+    void setSpacing(float spacing);
+
+    /// @brief Set the thickness (radius) of the surface
+    void setRadius(float radius);
+
+    /// @brief Remove all heights
+    void clear();
+
+    const std::vector<float> &heights() const { return _heights; }
+    const glm::vec2          &origin() const { return _origin; }
+    float                     spacing() const { return _spacing; }
+    float                     radius() const { return _radius; }
+
+    /// @brief Number of columns
+    uint32_t numSegments() const {
+        return _heights.size() < 2 ? 0 : uint32_t(_heights.size() - 1);
+    }
+
+    /// @brief Get column i
+    thick_line_segment_2d_t segment(uint32_t i) const {
+        const float x = _origin.x + float(i) * _spacing;
+        return {{{x, _origin.y + _heights[i]},
+                 {x + _spacing, _origin.y + _heights[i + 1]}},
+                _radius};
+    }
+
+    /// @brief Get the column sharing the start (or end) vertex of column i
+    /// @return false if the vertex is the first or last one
+    bool neighbor(uint32_t i, bool start, uint32_t &j) const {
+        if (start) {
+            if (i == 0) {
+                return false;
+            }
+            j = i - 1;
+            return true;
+        }
+        if (i + 1 >= numSegments()) {
+            return false;
+        }
+        j = i + 1;
+        return true;
+    }
+
+    /// @brief Bounds of the whole heightfield (including the thickness)
+    aabb_2d_t bounds() const;
+
+    /// @brief Call callback(uint32_t column) for every column whose bounds
+    /// overlap aabb.
+    template <typename Callback>
+    void query(const aabb_2d_t &aabb, Callback &&callback) const {
+        const uint32_t num_segments = numSegments();
+        if (num_segments == 0 || aabb.mx.x < _bounds.mn.x ||
+            aabb.mn.x > _bounds.mx.x) {
+            return;
+        }
+        // the columns under the aabb, widened by the thickness
+        const float inv_spacing = 1.0f / _spacing;
+        const float first =
+            std::floor((aabb.mn.x - _radius - _origin.x) * inv_spacing);
+        const float last =
+            std::floor((aabb.mx.x + _radius - _origin.x) * inv_spacing);
+        const uint32_t begin = uint32_t(std::max(first, 0.0f));
+        const uint32_t end =
+            uint32_t(std::clamp(last, 0.0f, float(num_segments - 1))) + 1;
+        for (uint32_t i = begin; i < end; i++) {
+            const float h0 = _origin.y + _heights[i];
+            const float h1 = _origin.y + _heights[i + 1];
+            if (std::min(h0, h1) - _radius <= aabb.mx.y &&
+                aabb.mn.y <= std::max(h0, h1) + _radius) {
+                callback(i);
+            }
+        }
+    }
+
+  private:
+    void updateBounds();
+
+  private:
+    std::vector<float> _heights;
+    glm::vec2          _origin = {0, 0};
+    float              _spacing = 1.0f;
+    float              _radius = 0.0f;
+    aabb_2d_t          _bounds = {glm::vec2(0), glm::vec2(0)};
+};
+
+} // namespace zo
+#endif // __zoPhysicsHeightfieldShape_h__
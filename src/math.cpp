@@ -10,6 +10,9 @@
  */
 #include <zero_physics/math.hpp>
 #include <iostream>
+#include <cmath>
+#include <limits>
+#include <algorithm>
 
 namespace zo {
 glm::vec2 closestPointOnLineSegment(const glm::vec2         &p,
@@ -92,4 +95,323 @@ bool circleToCircle(const circle_2d_t &c1, const circle_2d_t &c2,
 
     return true;
 }
+
+bool circleOverlapsCircle(const circle_2d_t &c1, const circle_2d_t &c2) {
+    const glm::vec2 diff = c2.center - c1.center;
+    const float     radius_sum = c1.radius + c2.radius;
+    return glm::dot(diff, diff) <= radius_sum * radius_sum;
+}
+
+bool circleOverlapsThickLineSegment(const circle_2d_t             &c,
+                                    const thick_line_segment_2d_t &ls) {
+    const glm::vec2 closest_point = closestPointOnLineSegment(c.center, ls.line);
+    return circleOverlapsCircle(c, {closest_point, ls.radius});
+}
+
+namespace {
+/// @brief twice the signed area of the triangle a, b, c
+float cross(const glm::vec2 &a, const glm::vec2 &b, const glm::vec2 &c) {
+    const glm::vec2 ab = b - a;
+    const glm::vec2 ac = c - a;
+    return ab.x * ac.y - ab.y * ac.x;
+}
+
+/// @brief check if two line segments properly cross
+bool lineSegmentsCross(const line_segment_2d_t &l1,
+                       const line_segment_2d_t &l2) {
+    const float d1 = cross(l2.start, l2.end, l1.start);
+    const float d2 = cross(l2.start, l2.end, l1.end);
+    const float d3 = cross(l1.start, l1.end, l2.start);
+    const float d4 = cross(l1.start, l1.end, l2.end);
+    return ((d1 > 0 && d2 < 0) || (d1 < 0 && d2 > 0)) &&
+           ((d3 > 0 && d4 < 0) || (d3 < 0 && d4 > 0));
+}
+
+/// @brief closest points of two line segments that do not cross.  One of
+/// them is always an end point.
+void closestPointsOfLineSegments(const line_segment_2d_t &l1,
+                                 const line_segment_2d_t &l2, glm::vec2 &p1,
+                                 glm::vec2 &p2) {
+    float best = std::numeric_limits<float>::max();
+    auto  test = [&](const glm::vec2 &a, const glm::vec2 &b) {
+        const glm::vec2 diff = b - a;
+        const float     squared_distance = glm::dot(diff, diff);
+        if (squared_distance < best) {
+            best = squared_distance;
+            p1 = a;
+            p2 = b;
+        }
+    };
+    test(l1.start, closestPointOnLineSegment(l1.start, l2));
+    test(l1.end, closestPointOnLineSegment(l1.end, l2));
+    test(closestPointOnLineSegment(l2.start, l1), l2.start);
+    test(closestPointOnLineSegment(l2.end, l1), l2.end);
+}
+} // namespace
+
+bool thickLineSegmentToThickLineSegment(const thick_line_segment_2d_t &ls1,
+                                        const thick_line_segment_2d_t &ls2,
+                                        contact_2d_t &contact) {
+    if (lineSegmentsCross(ls1.line, ls2.line)) {
+        // push ls1 out through the side of ls2 its shallower end is on
+        const glm::vec2 dir = glm::normalize(ls2.line.end - ls2.line.start);
+        const glm::vec2 normal = {-dir.y, dir.x};
+        const float     d_start = glm::dot(ls1.line.start - ls2.line.start, normal);
+        const float     d_end = glm::dot(ls1.line.end - ls2.line.start, normal);
+        const bool      start_is_shallow = std::abs(d_start) < std::abs(d_end);
+        const float     depth = start_is_shallow ? d_start : d_end;
+        contact.normal = depth > 0 ? normal : -normal;
+        contact.penetration = std::abs(depth) + ls1.radius + ls2.radius;
+        contact.point = start_is_shallow ? ls1.line.start : ls1.line.end;
+        return true;
+    }
+
+    // otherwise it is just a circle to circle collision at the closest points
+    glm::vec2 p1, p2;
+    closestPointsOfLineSegments(ls1.line, ls2.line, p1, p2);
+    return circleToCircle({p1, ls1.radius}, {p2, ls2.radius}, contact);
+}
+
+bool thickLineSegmentOverlapsThickLineSegment(
+    const thick_line_segment_2d_t &ls1, const thick_line_segment_2d_t &ls2) {
+    if (lineSegmentsCross(ls1.line, ls2.line)) {
+        return true;
+    }
+    glm::vec2 p1, p2;
+    closestPointsOfLineSegments(ls1.line, ls2.line, p1, p2);
+    return circleOverlapsCircle({p1, ls1.radius}, {p2, ls2.radius});
+}
+
+namespace {
+/// @brief the box x and y axes
+void boxAxes(const box_2d_t &b, glm::vec2 &x, glm::vec2 &y) {
+    const float c = std::cos(b.angle);
+    const float s = std::sin(b.angle);
+    x = {c, s};
+    y = {-s, c};
+}
+
+/// @brief half length of a box projected onto an axis
+float boxProjectedRadius(const box_2d_t &b, const glm::vec2 &x,
+                         const glm::vec2 &y, const glm::vec2 &axis) {
+    return b.half_extents.x * std::abs(glm::dot(x, axis)) +
+           b.half_extents.y * std::abs(glm::dot(y, axis));
+}
+} // namespace
+
+aabb_2d_t boxAabb(const box_2d_t &b) {
+    glm::vec2 x, y;
+    boxAxes(b, x, y);
+    const glm::vec2 extent = {boxProjectedRadius(b, x, y, {1, 0}),
+                              boxProjectedRadius(b, x, y, {0, 1})};
+    return {b.center - extent, b.center + extent};
+}
+
+bool circleToBox(const circle_2d_t &c, const box_2d_t &b,
+                 contact_2d_t &contact) {
+    // circle center in box space
+    glm::vec2 x, y;
+    boxAxes(b, x, y);
+    const glm::vec2 d = c.center - b.center;
+    const glm::vec2 local = {glm::dot(d, x), glm::dot(d, y)};
+    const glm::vec2 clamped = glm::clamp(local, -b.half_extents, b.half_extents);
+
+    if (local != clamped) {
+        // outside: circle against the closest point on the box
+        const glm::vec2 closest = b.center + x * clamped.x + y * clamped.y;
+        const glm::vec2 diff = closest - c.center;
+        const float     squared_distance = glm::dot(diff, diff);
+        if (squared_distance > c.radius * c.radius) {
+            return false;
+        }
+        const float distance = glm::sqrt(squared_distance);
+        contact.normal = diff / distance;
+        contact.penetration = c.radius - distance;
+        contact.point = closest;
+        return true;
+    }
+
+    // inside: push out through the nearest face
+    const glm::vec2 depth = b.half_extents - glm::abs(local);
+    if (depth.x < depth.y) {
+        contact.normal = local.x > 0 ? -x : x;
+        contact.penetration = c.radius + depth.x;
+    } else {
+        contact.normal = local.y > 0 ? -y : y;
+        contact.penetration = c.radius + depth.y;
+    }
+    contact.point = c.center;
+    return true;
+}
+
+bool thickLineSegmentToBox(const thick_line_segment_2d_t &ls,
+                           const box_2d_t &b, contact_2d_t &contact) {
+    glm::vec2 x, y;
+    boxAxes(b, x, y);
+    const glm::vec2 line = ls.line.end - ls.line.start;
+    const glm::vec2 mid = 0.5f * (ls.line.start + ls.line.end);
+    const glm::vec2 d = b.center - mid;
+
+    glm::vec2 axes[3] = {x, y, {0, 0}};
+    int       num_axes = 2;
+    const float length = glm::length(line);
+    if (length > EPSILON) {
+        axes[num_axes++] = glm::vec2(-line.y, line.x) / length;
+    }
+
+    // find the axis of least overlap.  The line projects to half its
+    // projected length plus its thickness.
+    float best = std::numeric_limits<float>::max();
+    for (int i = 0; i < num_axes; i++) {
+        const glm::vec2 &axis = axes[i];
+        const float      distance = glm::dot(d, axis);
+        const float      overlap =
+            boxProjectedRadius(b, x, y, axis) +
+            0.5f * std::abs(glm::dot(line, axis)) + ls.radius -
+            std::abs(distance);
+        if (overlap < 0) {
+            return false; // separating axis
+        }
+        if (overlap < best) {
+            best = overlap;
+            contact.normal = distance < 0 ? -axis : axis;
+        }
+    }
+    contact.penetration = best;
+    contact.point = closestPointOnLineSegment(b.center, ls.line);
+    return true;
+}
+
+bool boxToBox(const box_2d_t &b1, const box_2d_t &b2, contact_2d_t &contact) {
+    glm::vec2 x1, y1, x2, y2;
+    boxAxes(b1, x1, y1);
+    boxAxes(b2, x2, y2);
+    const glm::vec2 d = b2.center - b1.center;
+
+    // find the axis of least overlap
+    float best = std::numeric_limits<float>::max();
+    for (const glm::vec2 &axis : {x1, y1, x2, y2}) {
+        const float distance = glm::dot(d, axis);
+        const float overlap = boxProjectedRadius(b1, x1, y1, axis) +
+                              boxProjectedRadius(b2, x2, y2, axis) -
+                              std::abs(distance);
+        if (overlap < 0) {
+            return false; // separating axis
+        }
+        if (overlap < best) {
+            best = overlap;
+            contact.normal = distance < 0 ? -axis : axis;
+        }
+    }
+    contact.penetration = best;
+
+    // the contact point is the deepest vertex of b2 (averaged if it is an
+    // edge)
+    const glm::vec2 hx = x2 * b2.half_extents.x;
+    const glm::vec2 hy = y2 * b2.half_extents.y;
+    const glm::vec2 vertices[4] = {b2.center - hx - hy, b2.center + hx - hy,
+                                   b2.center + hx + hy, b2.center - hx + hy};
+    float deepest = std::numeric_limits<float>::max();
+    for (const glm::vec2 &v : vertices) {
+        deepest = std::min(deepest, glm::dot(v, contact.normal));
+    }
+    glm::vec2 point(0);
+    int       count = 0;
+    for (const glm::vec2 &v : vertices) {
+        if (glm::dot(v, contact.normal) <= deepest + 1e-3f) {
+            point += v;
+            count++;
+        }
+    }
+    contact.point = point / float(count);
+    return true;
+}
+
+namespace {
+/// @brief first time [0, 1] a point moving by d comes within radius of
+/// center, assuming it starts outside
+bool timeOfImpactPointToCircle(const glm::vec2 &p, const glm::vec2 &d,
+                               const glm::vec2 &center, float radius,
+                               float &toi) {
+    // solve |p + d * t - center| = radius for the smallest t
+    const glm::vec2 m = p - center;
+    const float     a = glm::dot(d, d);
+    const float     b = glm::dot(m, d);
+    const float     c = glm::dot(m, m) - radius * radius;
+    if (a <= EPSILON || b >= 0) {
+        return false; // not moving or moving away
+    }
+    const float discriminant = b * b - a * c;
+    if (discriminant < 0) {
+        return false;
+    }
+    const float t = (-b - glm::sqrt(discriminant)) / a;
+    if (t < 0 || t > 1) {
+        return false;
+    }
+    toi = t;
+    return true;
+}
+} // namespace
+
+bool timeOfImpactCircleToCircle(const circle_2d_t &c1, const glm::vec2 &d1,
+                                const circle_2d_t &c2, const glm::vec2 &d2,
+                                float &toi) {
+    // move circle 1 relative to circle 2, which is then a point against a
+    // circle of the summed radii
+    if (circleOverlapsCircle(c1, c2)) {
+        toi = 0;
+        return true;
+    }
+    return timeOfImpactPointToCircle(c1.center, d1 - d2, c2.center,
+                                     c1.radius + c2.radius, toi);
+}
+
+bool timeOfImpactCircleToThickLineSegment(const circle_2d_t             &c,
+                                          const glm::vec2               &d,
+                                          const thick_line_segment_2d_t &ls,
+                                          float                         &toi) {
+    if (circleOverlapsThickLineSegment(c, ls)) {
+        toi = 0;
+        return true;
+    }
+
+    // the circle center against the line segment grown by the circle radius
+    // (a capsule).  Test the two end caps and the two sides.
+    const float radius = c.radius + ls.radius;
+    bool        hit = false;
+    float       t = 0;
+    toi = 1;
+    for (const glm::vec2 &end : {ls.line.start, ls.line.end}) {
+        if (timeOfImpactPointToCircle(c.center, d, end, radius, t) &&
+            t <= toi) {
+            toi = t;
+            hit = true;
+        }
+    }
+
+    const glm::vec2 line = ls.line.end - ls.line.start;
+    const float     length = glm::length(line);
+    if (length <= EPSILON) {
+        return hit;
+    }
+    const glm::vec2 dir = line / length;
+    const glm::vec2 normal = {-dir.y, dir.x};
+
+    // crossing the side facing the circle
+    const float distance = glm::dot(c.center - ls.line.start, normal);
+    const float side = distance > 0 ? radius : -radius;
+    const float speed = glm::dot(d, normal);
+    if (speed * side < 0) {
+        t = (side - distance) / speed;
+        const float along =
+            glm::dot(c.center + d * t - ls.line.start, dir);
+        if (t >= 0 && t <= toi && along >= 0 && along <= length) {
+            toi = t;
+            hit = true;
+        }
+    }
+    return hit;
+}
+
 } // namespace zo
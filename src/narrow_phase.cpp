@@ -0,0 +1,313 @@
+#include "narrow_phase.hpp"
+#include "polyline.hpp"
+#include <zero_physics/math.hpp>
+#include <algorithm>
+#include <cmath>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+namespace zo {
+
+namespace {
+/// @brief Slop added to a radius when evaluating the contact at the time of
+/// impact, where the colliders only just touch.
+constexpr float TOI_SLOP = 1e-3f;
+} // namespace
+
+// Circles that swept (see: Collider2dImpl::Data::sweep) contact at their
+// time of impact.
+
+bool NarrowPhaseKernel<ColliderType::CIRCLE, ColliderType::CIRCLE>::collide(
+    const CircleCollider2dImpl::Data &a, const CircleCollider2dImpl::Data &b,
+    contact_2d_t &contact, float &toi) {
+    toi = 1.0f;
+    if (a.sweep == glm::vec2(0) && b.sweep == glm::vec2(0)) {
+        return circleToCircle(a.circle, b.circle, contact);
+    }
+    const circle_2d_t start_a = {a.circle.center - a.sweep, a.circle.radius};
+    const circle_2d_t start_b = {b.circle.center - b.sweep, b.circle.radius};
+    if (timeOfImpactCircleToCircle(start_a, a.sweep, start_b, b.sweep, toi) ==
+        false) {
+        return false;
+    }
+    const circle_2d_t at_a = {start_a.center + a.sweep * toi,
+                              start_a.radius + TOI_SLOP};
+    const circle_2d_t at_b = {start_b.center + b.sweep * toi, start_b.radius};
+    if (circleToCircle(at_a, at_b, contact) == false) {
+        return false;
+    }
+    contact.penetration = std::max(contact.penetration - TOI_SLOP, 0.0f);
+    return true;
+}
+
+bool NarrowPhaseKernel<ColliderType::CIRCLE, ColliderType::CIRCLE>::overlaps(
+    const CircleCollider2dImpl::Data &a, const CircleCollider2dImpl::Data &b) {
+    return circleOverlapsCircle(a.circle, b.circle);
+}
+
+bool NarrowPhaseKernel<ColliderType::CIRCLE, ColliderType::LINE>::collide(
+    const CircleCollider2dImpl::Data &a, const LineCollider2dImpl::Data &b,
+    contact_2d_t &contact, float &toi) {
+    toi = 1.0f;
+    if (a.sweep == glm::vec2(0)) {
+        return circleToThickLineSegment(a.circle, b.line, contact);
+    }
+    const circle_2d_t start = {a.circle.center - a.sweep, a.circle.radius};
+    if (timeOfImpactCircleToThickLineSegment(start, a.sweep, b.line, toi) ==
+        false) {
+        return false;
+    }
+    const circle_2d_t at = {start.center + a.sweep * toi,
+                            start.radius + TOI_SLOP};
+    if (circleToThickLineSegment(at, b.line, contact) == false) {
+        return false;
+    }
+    contact.penetration = std::max(contact.penetration - TOI_SLOP, 0.0f);
+    return true;
+}
+
+bool NarrowPhaseKernel<ColliderType::CIRCLE, ColliderType::LINE>::overlaps(
+    const CircleCollider2dImpl::Data &a, const LineCollider2dImpl::Data &b) {
+    return circleOverlapsThickLineSegment(a.circle, b.line);
+}
+
+bool NarrowPhaseKernel<ColliderType::LINE, ColliderType::LINE>::collide(
+    const LineCollider2dImpl::Data &a, const LineCollider2dImpl::Data &b,
+    contact_2d_t &contact, float &toi) {
+    toi = 1.0f;
+    return thickLineSegmentToThickLineSegment(a.line, b.line, contact);
+}
+
+bool NarrowPhaseKernel<ColliderType::LINE, ColliderType::LINE>::overlaps(
+    const LineCollider2dImpl::Data &a, const LineCollider2dImpl::Data &b) {
+    return thickLineSegmentOverlapsThickLineSegment(a.line, b.line);
+}
+
+// Boxes have no time of impact, circles are tested at the end of the step.
+
+bool NarrowPhaseKernel<ColliderType::CIRCLE, ColliderType::BOX>::collide(
+    const CircleCollider2dImpl::Data &a, const BoxCollider2dImpl::Data &b,
+    contact_2d_t &contact, float &toi) {
+    toi = 1.0f;
+    return circleToBox(a.circle, b.box, contact);
+}
+
+bool NarrowPhaseKernel<ColliderType::CIRCLE, ColliderType::BOX>::overlaps(
+    const CircleCollider2dImpl::Data &a, const BoxCollider2dImpl::Data &b) {
+    contact_2d_t contact;
+    return circleToBox(a.circle, b.box, contact);
+}
+
+bool NarrowPhaseKernel<ColliderType::LINE, ColliderType::BOX>::collide(
+    const LineCollider2dImpl::Data &a, const BoxCollider2dImpl::Data &b,
+    contact_2d_t &contact, float &toi) {
+    toi = 1.0f;
+    return thickLineSegmentToBox(a.line, b.box, contact);
+}
+
+bool NarrowPhaseKernel<ColliderType::LINE, ColliderType::BOX>::overlaps(
+    const LineCollider2dImpl::Data &a, const BoxCollider2dImpl::Data &b) {
+    contact_2d_t contact;
+    return thickLineSegmentToBox(a.line, b.box, contact);
+}
+
+bool NarrowPhaseKernel<ColliderType::BOX, ColliderType::BOX>::collide(
+    const BoxCollider2dImpl::Data &a, const BoxCollider2dImpl::Data &b,
+    contact_2d_t &contact, float &toi) {
+    toi = 1.0f;
+    return boxToBox(a.box, b.box, contact);
+}
+
+bool NarrowPhaseKernel<ColliderType::BOX, ColliderType::BOX>::overlaps(
+    const BoxCollider2dImpl::Data &a, const BoxCollider2dImpl::Data &b) {
+    contact_2d_t contact;
+    return boxToBox(a.box, b.box, contact);
+}
+
+// Polylines only test the segments near the other collider.  See:
+// polyline.hpp
+
+namespace {
+template <typename Shape>
+bool circleToPolylineAtImpact(const CircleCollider2dImpl::Data &a,
+                              const Shape &shape, contact_2d_t &contact,
+                              float &toi) {
+    toi = 1.0f;
+    if (a.sweep == glm::vec2(0)) {
+        return circleToPolyline(shape, a.circle, contact);
+    }
+    const circle_2d_t start = {a.circle.center - a.sweep, a.circle.radius};
+    if (timeOfImpactCircleToPolyline(shape, start, a.sweep, toi) == false) {
+        return false;
+    }
+    const circle_2d_t at = {start.center + a.sweep * toi,
+                            start.radius + TOI_SLOP};
+    if (circleToPolyline(shape, at, contact) == false) {
+        return false;
+    }
+    contact.penetration = std::max(contact.penetration - TOI_SLOP, 0.0f);
+    return true;
+}
+} // namespace
+
+bool NarrowPhaseKernel<ColliderType::CIRCLE, ColliderType::CHAIN>::collide(
+    const CircleCollider2dImpl::Data &a, const ChainCollider2dImpl::Data &b,
+    contact_2d_t &contact, float &toi) {
+    return circleToPolylineAtImpact(a, *b.shape, contact, toi);
+}
+
+bool NarrowPhaseKernel<ColliderType::CIRCLE, ColliderType::CHAIN>::overlaps(
+    const CircleCollider2dImpl::Data &a, const ChainCollider2dImpl::Data &b) {
+    return circleOverlapsPolyline(*b.shape, a.circle);
+}
+
+bool NarrowPhaseKernel<ColliderType::BOX, ColliderType::CHAIN>::collide(
+    const BoxCollider2dImpl::Data &a, const ChainCollider2dImpl::Data &b,
+    contact_2d_t &contact, float &toi) {
+    toi = 1.0f;
+    return boxToPolyline(*b.shape, a.box, contact);
+}
+
+bool NarrowPhaseKernel<ColliderType::BOX, ColliderType::CHAIN>::overlaps(
+    const BoxCollider2dImpl::Data &a, const ChainCollider2dImpl::Data &b) {
+    contact_2d_t contact;
+    return boxToPolyline(*b.shape, a.box, contact);
+}
+
+bool NarrowPhaseKernel<ColliderType::CIRCLE, ColliderType::HEIGHTFIELD>::
+    collide(const CircleCollider2dImpl::Data      &a,
+            const HeightfieldCollider2dImpl::Data &b, contact_2d_t &contact,
+            float &toi) {
+    return circleToPolylineAtImpact(a, *b.shape, contact, toi);
+}
+
+bool NarrowPhaseKernel<ColliderType::CIRCLE, ColliderType::HEIGHTFIELD>::
+    overlaps(const CircleCollider2dImpl::Data      &a,
+             const HeightfieldCollider2dImpl::Data &b) {
+    return circleOverlapsPolyline(*b.shape, a.circle);
+}
+
+bool NarrowPhaseKernel<ColliderType::BOX, ColliderType::HEIGHTFIELD>::collide(
+    const BoxCollider2dImpl::Data &a, const HeightfieldCollider2dImpl::Data &b,
+    contact_2d_t &contact, float &toi) {
+    toi = 1.0f;
+    return boxToPolyline(*b.shape, a.box, contact);
+}
+
+bool NarrowPhaseKernel<ColliderType::BOX, ColliderType::HEIGHTFIELD>::
+    overlaps(const BoxCollider2dImpl::Data         &a,
+             const HeightfieldCollider2dImpl::Data &b) {
+    contact_2d_t contact;
+    return boxToPolyline(*b.shape, a.box, contact);
+}
+
+void CircleCircleBatch::clear() { _size = 0; }
+
+size_t CircleCircleBatch::add(const circle_2d_t &c1, const circle_2d_t &c2) {
+    if (_size == _x1.size()) {
+        // grow a block of lanes at a time so the kernels always load full
+        // registers
+        const size_t capacity = _x1.size() + LANES * (1 + _x1.size() / LANES);
+        for (std::vector<float> *v :
+             {&_x1, &_y1, &_r1, &_x2, &_y2, &_r2, &_nx, &_ny, &_px, &_py,
+              &_penetration}) {
+            v->resize(capacity, 0.0f);
+        }
+        _hit.resize(capacity / LANES, 0);
+    }
+    _x1[_size] = c1.center.x;
+    _y1[_size] = c1.center.y;
+    _r1[_size] = c1.radius;
+    _x2[_size] = c2.center.x;
+    _y2[_size] = c2.center.y;
+    _r2[_size] = c2.radius;
+    return _size++;
+}
+
+void CircleCircleBatch::collide() {
+    // same math as circleToCircle():
+    //   hit = |c2 - c1|^2 <= (r1 + r2)^2
+    //   normal = (c2 - c1) / |c2 - c1|
+    //   penetration = r1 + r2 - |c2 - c1|
+    //   point = c1 + normal * r1
+    const size_t num_blocks = (_size + LANES - 1) / LANES;
+    for (size_t b = 0; b < num_blocks; b++) {
+        const size_t i = b * LANES;
+#if defined(__AVX2__)
+        const __m256 x1 = _mm256_loadu_ps(&_x1[i]);
+        const __m256 y1 = _mm256_loadu_ps(&_y1[i]);
+        const __m256 r1 = _mm256_loadu_ps(&_r1[i]);
+        const __m256 dx = _mm256_sub_ps(_mm256_loadu_ps(&_x2[i]), x1);
+        const __m256 dy = _mm256_sub_ps(_mm256_loadu_ps(&_y2[i]), y1);
+        const __m256 radius_sum = _mm256_add_ps(r1, _mm256_loadu_ps(&_r2[i]));
+        const __m256 squared_distance =
+            _mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy));
+        const __m256 hit =
+            _mm256_cmp_ps(squared_distance,
+                          _mm256_mul_ps(radius_sum, radius_sum), _CMP_LE_OQ);
+        const __m256 distance = _mm256_sqrt_ps(squared_distance);
+        const __m256 inv_distance =
+            _mm256_div_ps(_mm256_set1_ps(1.0f), distance);
+        const __m256 nx = _mm256_mul_ps(dx, inv_distance);
+        const __m256 ny = _mm256_mul_ps(dy, inv_distance);
+        _mm256_storeu_ps(&_nx[i], nx);
+        _mm256_storeu_ps(&_ny[i], ny);
+        _mm256_storeu_ps(&_penetration[i], _mm256_sub_ps(radius_sum, distance));
+        _mm256_storeu_ps(&_px[i], _mm256_add_ps(x1, _mm256_mul_ps(nx, r1)));
+        _mm256_storeu_ps(&_py[i], _mm256_add_ps(y1, _mm256_mul_ps(ny, r1)));
+        _hit[b] = uint8_t(_mm256_movemask_ps(hit));
+#elif defined(__SSE2__) || defined(_M_X64)
+        uint8_t mask = 0;
+        for (size_t h = 0; h < LANES; h += 4) {
+            const __m128 x1 = _mm_loadu_ps(&_x1[i + h]);
+            const __m128 y1 = _mm_loadu_ps(&_y1[i + h]);
+            const __m128 r1 = _mm_loadu_ps(&_r1[i + h]);
+            const __m128 dx = _mm_sub_ps(_mm_loadu_ps(&_x2[i + h]), x1);
+            const __m128 dy = _mm_sub_ps(_mm_loadu_ps(&_y2[i + h]), y1);
+            const __m128 radius_sum = _mm_add_ps(r1, _mm_loadu_ps(&_r2[i + h]));
+            const __m128 squared_distance =
+                _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+            const __m128 hit = _mm_cmple_ps(
+                squared_distance, _mm_mul_ps(radius_sum, radius_sum));
+            const __m128 distance = _mm_sqrt_ps(squared_distance);
+            const __m128 inv_distance = _mm_div_ps(_mm_set1_ps(1.0f), distance);
+            const __m128 nx = _mm_mul_ps(dx, inv_distance);
+            const __m128 ny = _mm_mul_ps(dy, inv_distance);
+            _mm_storeu_ps(&_nx[i + h], nx);
+            _mm_storeu_ps(&_ny[i + h], ny);
+            _mm_storeu_ps(&_penetration[i + h],
+                          _mm_sub_ps(radius_sum, distance));
+            _mm_storeu_ps(&_px[i + h], _mm_add_ps(x1, _mm_mul_ps(nx, r1)));
+            _mm_storeu_ps(&_py[i + h], _mm_add_ps(y1, _mm_mul_ps(ny, r1)));
+            mask |= uint8_t(_mm_movemask_ps(hit) << h);
+        }
+        _hit[b] = mask;
+#else
+        uint8_t mask = 0;
+        for (size_t h = 0; h < LANES; h++) {
+            const size_t p = i + h;
+            const float  dx = _x2[p] - _x1[p];
+            const float  dy = _y2[p] - _y1[p];
+            const float  radius_sum = _r1[p] + _r2[p];
+            const float  squared_distance = dx * dx + dy * dy;
+            const float  distance = std::sqrt(squared_distance);
+            const float  inv_distance = 1.0f / distance;
+            _nx[p] = dx * inv_distance;
+            _ny[p] = dy * inv_distance;
+            _penetration[p] = radius_sum - distance;
+            _px[p] = _x1[p] + _nx[p] * _r1[p];
+            _py[p] = _y1[p] + _ny[p] * _r1[p];
+            if (squared_distance <= radius_sum * radius_sum) {
+                mask |= uint8_t(1 << h);
+            }
+        }
+        _hit[b] = mask;
+#endif
+    }
+}
+
+} // namespace zo
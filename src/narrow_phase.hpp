@@ -0,0 +1,212 @@
+/**
+ * @file narrow_phase.hpp
+ * @author Micah Pearlman (micahpearlman@gmail.com)
+ * @brief Batched narrow phase kernels.
+ * @version 0.1
+ * @date 2024-10-28
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#ifndef __zoPhysicsNarrowPhase_h__
+#define __zoPhysicsNarrowPhase_h__
+#include <zero_physics/types.hpp>
+#include "collider_2d_impl.hpp"
+#include "types_impl.hpp"
+#include <cstdint>
+#include <vector>
+
+namespace zo {
+
+/// @brief The collider data of a collider type
+template <ColliderType T> struct ColliderDataOf {
+    using type = Collider2dImpl::Data;
+};
+template <> struct ColliderDataOf<ColliderType::CIRCLE> {
+    using type = CircleCollider2dImpl::Data;
+};
+template <> struct ColliderDataOf<ColliderType::LINE> {
+    using type = LineCollider2dImpl::Data;
+};
+template <> struct ColliderDataOf<ColliderType::BOX> {
+    using type = BoxCollider2dImpl::Data;
+};
+template <> struct ColliderDataOf<ColliderType::CHAIN> {
+    using type = ChainCollider2dImpl::Data;
+};
+template <> struct ColliderDataOf<ColliderType::HEIGHTFIELD> {
+    using type = HeightfieldCollider2dImpl::Data;
+};
+
+/// @brief Narrow phase kernel of a pair of collider types.  Pairs are put in
+/// canonical order (see: canonicalPair()) so only A <= B is specialized.
+/// Combinations without a specialization never collide.
+///
+/// A kernel provides:
+///   static bool collide(const DataA &, const DataB &, contact_2d_t &,
+///                       float &toi);
+///   static bool overlaps(const DataA &, const DataB &);
+/// The contact normal points from A to B.
+template <ColliderType A, ColliderType B> struct NarrowPhaseKernel {
+    static constexpr bool supported = false;
+};
+
+template <>
+struct NarrowPhaseKernel<ColliderType::CIRCLE, ColliderType::CIRCLE> {
+    static constexpr bool supported = true;
+    static bool           collide(const CircleCollider2dImpl::Data &a,
+                                  const CircleCollider2dImpl::Data &b,
+                                  contact_2d_t &contact, float &toi);
+    static bool           overlaps(const CircleCollider2dImpl::Data &a,
+                                   const CircleCollider2dImpl::Data &b);
+};
+
+template <> struct NarrowPhaseKernel<ColliderType::CIRCLE, ColliderType::LINE> {
+    static constexpr bool supported = true;
+    static bool           collide(const CircleCollider2dImpl::Data &a,
+                                  const LineCollider2dImpl::Data   &b,
+                                  contact_2d_t &contact, float &toi);
+    static bool           overlaps(const CircleCollider2dImpl::Data &a,
+                                   const LineCollider2dImpl::Data   &b);
+};
+
+template <> struct NarrowPhaseKernel<ColliderType::LINE, ColliderType::LINE> {
+    static constexpr bool supported = true;
+    static bool           collide(const LineCollider2dImpl::Data &a,
+                                  const LineCollider2dImpl::Data &b,
+                                  contact_2d_t &contact, float &toi);
+    static bool           overlaps(const LineCollider2dImpl::Data &a,
+                                   const LineCollider2dImpl::Data &b);
+};
+
+template <> struct NarrowPhaseKernel<ColliderType::CIRCLE, ColliderType::BOX> {
+    static constexpr bool supported = true;
+    static bool           collide(const CircleCollider2dImpl::Data &a,
+                                  const BoxCollider2dImpl::Data    &b,
+                                  contact_2d_t &contact, float &toi);
+    static bool           overlaps(const CircleCollider2dImpl::Data &a,
+                                   const BoxCollider2dImpl::Data    &b);
+};
+
+template <> struct NarrowPhaseKernel<ColliderType::LINE, ColliderType::BOX> {
+    static constexpr bool supported = true;
+    static bool           collide(const LineCollider2dImpl::Data &a,
+                                  const BoxCollider2dImpl::Data  &b,
+                                  contact_2d_t &contact, float &toi);
+    static bool           overlaps(const LineCollider2dImpl::Data &a,
+                                   const BoxCollider2dImpl::Data  &b);
+};
+
+template <> struct NarrowPhaseKernel<ColliderType::BOX, ColliderType::BOX> {
+    static constexpr bool supported = true;
+    static bool           collide(const BoxCollider2dImpl::Data &a,
+                                  const BoxCollider2dImpl::Data &b,
+                                  contact_2d_t &contact, float &toi);
+    static bool           overlaps(const BoxCollider2dImpl::Data &a,
+                                   const BoxCollider2dImpl::Data &b);
+};
+
+template <>
+struct NarrowPhaseKernel<ColliderType::CIRCLE, ColliderType::CHAIN> {
+    static constexpr bool supported = true;
+    static bool           collide(const CircleCollider2dImpl::Data &a,
+                                  const ChainCollider2dImpl::Data  &b,
+                                  contact_2d_t &contact, float &toi);
+    static bool           overlaps(const CircleCollider2dImpl::Data &a,
+                                   const ChainCollider2dImpl::Data  &b);
+};
+
+template <> struct NarrowPhaseKernel<ColliderType::BOX, ColliderType::CHAIN> {
+    static constexpr bool supported = true;
+    static bool           collide(const BoxCollider2dImpl::Data   &a,
+                                  const ChainCollider2dImpl::Data &b,
+                                  contact_2d_t &contact, float &toi);
+    static bool           overlaps(const BoxCollider2dImpl::Data   &a,
+                                   const ChainCollider2dImpl::Data &b);
+};
+
+template <>
+struct NarrowPhaseKernel<ColliderType::CIRCLE, ColliderType::HEIGHTFIELD> {
+    static constexpr bool supported = true;
+    static bool collide(const CircleCollider2dImpl::Data      &a,
+                        const HeightfieldCollider2dImpl::Data &b,
+                        contact_2d_t &contact, float &toi);
+    static bool overlaps(const CircleCollider2dImpl::Data      &a,
+                         const HeightfieldCollider2dImpl::Data &b);
+};
+
+template <>
+struct NarrowPhaseKernel<ColliderType::BOX, ColliderType::HEIGHTFIELD> {
+    static constexpr bool supported = true;
+    static bool collide(const BoxCollider2dImpl::Data         &a,
+                        const HeightfieldCollider2dImpl::Data &b,
+                        contact_2d_t &contact, float &toi);
+    static bool overlaps(const BoxCollider2dImpl::Data         &a,
+                         const HeightfieldCollider2dImpl::Data &b);
+};
+
+/// @brief Put a pair in canonical order, lower collider type first
+inline CollisionPair canonicalPair(const CollisionPair &pair) {
+    if (pair.a.type > pair.b.type) {
+        return {pair.b, pair.a, pair.contact, pair.toi};
+    }
+    return pair;
+}
+
+/// @brief Number of ColliderType x ColliderType combinations.  The narrow
+/// phase buckets the pairs by combination and runs the kernel of each
+/// bucket directly.
+constexpr size_t NUM_COLLIDER_TYPE_PAIRS =
+    size_t(ColliderType::MAX) * size_t(ColliderType::MAX);
+
+/// @brief Get the collider type combination of a canonical pair
+inline size_t colliderTypePair(const CollisionPair &pair) {
+    return pair.a.type * size_t(ColliderType::MAX) + pair.b.type;
+}
+
+/// @brief Batched circle vs circle narrow phase.
+/// Circle pairs are gathered into SoA arrays and collided LANES at a time
+/// (AVX2, SSE2 or scalar).  Results match circleToCircle().
+class CircleCircleBatch {
+  public:
+    static constexpr size_t LANES = 8;
+
+    /// @brief Remove all circle pairs
+    void clear();
+
+    /// @brief Add a circle pair
+    /// @return the index of the pair in the batch
+    size_t add(const circle_2d_t &c1, const circle_2d_t &c2);
+
+    /// @brief Number of circle pairs in the batch
+    size_t size() const { return _size; }
+
+    /// @brief Collide all the circle pairs
+    void collide();
+
+    /// @brief Check if a circle pair collided.  Valid after collide().
+    /// @param i the index of the pair
+    bool hit(size_t i) const { return (_hit[i / LANES] >> (i % LANES)) & 1; }
+
+    /// @brief Get the contact of a colliding circle pair
+    /// @param i the index of the pair
+    contact_2d_t contact(size_t i) const {
+        return {{_nx[i], _ny[i]}, {_px[i], _py[i]}, _penetration[i]};
+    }
+
+  private:
+    size_t _size = 0;
+
+    // inputs, padded to a multiple of LANES
+    std::vector<float> _x1, _y1, _r1;
+    std::vector<float> _x2, _y2, _r2;
+
+    // outputs
+    std::vector<uint8_t> _hit; // one bit per pair
+    std::vector<float>   _nx, _ny;
+    std::vector<float>   _px, _py;
+    std::vector<float>   _penetration;
+};
+
+} // namespace zo
+#endif // __zoPhysicsNarrowPhase_h__
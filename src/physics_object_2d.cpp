@@ -22,42 +22,52 @@ PhysicsObject2dImpl::~PhysicsObject2dImpl() {
     }
 }
 
-void PhysicsObject2dImpl::setMass(float mass) { data().mass = mass; }
+void PhysicsObject2dImpl::setMass(float mass) {
+    store().setMass(index(), mass);
+    _sys.syncColliderStatic(data().collider);
+}
 
 float PhysicsObject2dImpl::mass() const { return data().mass; }
 
 void PhysicsObject2dImpl::setPosition(const glm::vec2 &p) {
-    data().position = p;
-    data().prev_position = p;
+    store().setPosition(index(), p);
+    store().setPrevPosition(index(), p);
 }
 
-glm::vec2 PhysicsObject2dImpl::position() const { return data().position; }
+glm::vec2 PhysicsObject2dImpl::position() const {
+    return store().position(index());
+}
 
 void PhysicsObject2dImpl::setVelocity(const glm::vec2 &v) {
     // because velocity isn't explicit in verlet we will "trick"
     // velocity by setting the previous position to the current
     // position
     // minus the velocity
-    data().prev_position = data().position - (v * _sys.lastTimeStep());
+    store().setPrevPosition(index(), store().position(index()) -
+                                         (v * _sys.lastTimeStep()));
 }
 
 glm::vec2 PhysicsObject2dImpl::velocity() const {
     // remember that velocity isn't explicit in verlet so we will
     // calculate it
-    return data().position - data().prev_position;
+    return store().position(index()) - store().prevPosition(index());
 }
 
 void PhysicsObject2dImpl::setAcceleration(const glm::vec2 &a) {
-    data().acceleration = a;
+    store().setAcceleration(index(), a);
 }
 
 glm::vec2 PhysicsObject2dImpl::acceleration() const {
-    return data().acceleration;
+    return store().acceleration(index());
 }
 
-void PhysicsObject2dImpl::addForce(const glm::vec2 &f) { data().force += f; }
+void PhysicsObject2dImpl::addForce(const glm::vec2 &f) {
+    store().setForce(index(), store().force(index()) + f);
+}
 
-void PhysicsObject2dImpl::zeroForce() { data().force = glm::vec2(0); }
+void PhysicsObject2dImpl::zeroForce() {
+    store().setForce(index(), glm::vec2(0));
+}
 
 bool PhysicsObject2dImpl::isValid() const {
     return _sys.isPhysicsHandleValid(_hndl);
@@ -69,9 +79,19 @@ void PhysicsObject2dImpl::setStatic(bool is_static) {
 
 bool PhysicsObject2dImpl::isStatic() const { return data().mass <= 0.0f; }
 
+void PhysicsObject2dImpl::setBullet(bool is_bullet) {
+    data().is_bullet = is_bullet;
+}
+
+bool PhysicsObject2dImpl::isBullet() const { return data().is_bullet; }
+
 void PhysicsObject2dImpl::setCollider(collider_handle_2d_t col_hndl, uint32_t vertex) {
+    const collider_handle_2d_t old_hndl = data().collider;
     data().collider_vertex = vertex;
     data().collider = col_hndl;
+    if (old_hndl.handle != col_hndl.handle) {
+        _sys.unmapColliderFromPhysicsObject(old_hndl, handle());
+    }
     _sys.mapColliderToPhysicsObject(col_hndl, handle());
 }
 
@@ -89,25 +109,38 @@ const PhysicsObject2dImpl::Data &PhysicsObject2dImpl::data() const {
     return _sys.physicsObjectData(_hndl);
 }
 
-void PhysicsObject2dImpl::applyImpulse(PhysicsObject2dImpl::Data &data, const glm::vec2 &impulse, const float time_step) {
+PhysicsObjectStore &PhysicsObject2dImpl::store() {
+    return _sys.physicsObjects();
+}
+
+const PhysicsObjectStore &PhysicsObject2dImpl::store() const {
+    return _sys.physicsObjects();
+}
+
+size_t PhysicsObject2dImpl::index() const { return store().index(_hndl); }
+
+void PhysicsObject2dImpl::applyImpulse(PhysicsObjectStore &store, size_t idx,
+                                       const glm::vec2 &impulse,
+                                       const float      time_step) {
     // ignore static objects
-    if (data.mass <= 0) {
+    if (store.inverseMass(idx) <= 0) {
         return;
     }
     // derive velocity.  This is a verlet integrator so velocity is
     // implicit so we will calculate it from the previous position to the
     // current position
-    glm::vec2 velocity = (data.prev_position - data.position) / time_step;
+    const glm::vec2 position = store.position(idx);
+    glm::vec2 velocity = (store.prevPosition(idx) - position) / time_step;
 
     // calculate the impulse preserving momentum
-    glm::vec2 delta_velocity = impulse / data.mass;
+    glm::vec2 delta_velocity = impulse * store.inverseMass(idx);
 
     // new velocity
     glm::vec2 new_velocity = velocity + delta_velocity;
 
     // update the previous position to reflect the new velocity
     // again this is a verlet integrator so we set the previous position
-    data.prev_position = data.position - new_velocity * time_step;
+    store.setPrevPosition(idx, position - new_velocity * time_step);
 
 }
 
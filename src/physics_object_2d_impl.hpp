@@ -18,21 +18,22 @@ namespace zo {
 
 // forward declare
 class PhysicsSystem2dImpl;
+class PhysicsObjectStore;
 
 /// @brief A view of the physics object data
 class PhysicsObject2dImpl : public PhysicsObject2d {
 
   public:
-    /// @brief The data for a physics object
+    /// @brief The data for a physics object the integrator does not touch.
+    /// Position, previous position, force and acceleration are kept in
+    /// arrays of their own.  See: PhysicsObjectStore
     struct alignas(std::max_align_t) Data {
-        glm::vec2            position = {0, 0};
-        glm::vec2            prev_position = {0, 0};
-        glm::vec2            acceleration = {0, 0};
-        glm::vec2            force = {0, 0};
         collider_handle_2d_t collider = {uint16_t(ColliderType::MAX),
                                          0xfffffff};
         uint32_t             collider_vertex = 0;
         float                mass = 1;
+        /// @brief bullets always use continuous collision detection
+        bool                 is_bullet = false;
     };
 
   public:
@@ -52,6 +53,8 @@ class PhysicsObject2dImpl : public PhysicsObject2d {
     bool      isValid() const override;
     void      setStatic(bool is_static) override;
     bool      isStatic() const override;
+    void      setBullet(bool is_bullet) override;
+    bool      isBullet() const override;
     void      setCollider(collider_handle_2d_t hndl, uint32_t vertex) override;
     void      setCollider(Collider2d &collider, uint32_t vertex) override;
 
@@ -65,12 +68,20 @@ class PhysicsObject2dImpl : public PhysicsObject2d {
     /// @return const PhysicsObject2dImpl::Data& the physics object data
     const PhysicsObject2dImpl::Data &data() const;
 
-    /// @brief Apply an impulse to the physics object
+    /// @brief Apply an impulse to a physics object
+    /// @param store the physics object store
+    /// @param idx the index of the physics object in the store
     /// @param impulse the impulse to apply
     /// @param time_step the time step
-    static void applyImpulse(PhysicsObject2dImpl::Data &data,
+    static void applyImpulse(PhysicsObjectStore &store, size_t idx,
                              const glm::vec2 &impulse, const float time_step);
 
+  private:
+    /// @brief Get the physics object store and the index of this object
+    PhysicsObjectStore       &store();
+    const PhysicsObjectStore &store() const;
+    size_t                    index() const;
+
   private:
     PhysicsSystem2dImpl &_sys;
     phy_obj_handle_2d_t  _hndl;
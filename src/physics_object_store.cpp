@@ -0,0 +1,179 @@
+#include "physics_object_store.hpp"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+namespace zo {
+
+PhysicsObjectStore::handle_t PhysicsObjectStore::add() {
+    const size_t idx = _data.size();
+    _data.emplace_back();
+    if (idx == _position_x.size()) {
+        // grow a block of lanes at a time so integrate() always loads full
+        // registers.  Padding objects have inverse mass 0, i.e., are static.
+        for (std::vector<float> *v :
+             {&_position_x, &_position_y, &_prev_position_x, &_prev_position_y,
+              &_force_x, &_force_y, &_acceleration_x, &_acceleration_y,
+              &_inv_mass}) {
+            v->resize(idx + LANES, 0.0f);
+        }
+    }
+    setMass(idx, _data[idx].mass);
+
+    _handle_to_idx[_next_handle] = uint32_t(idx);
+    _idx_to_handle.push_back(_next_handle);
+    return _next_handle++;
+}
+
+void PhysicsObjectStore::remove(handle_t hndl) {
+    auto it = _handle_to_idx.find(hndl);
+    if (it == _handle_to_idx.end()) {
+        return;
+    }
+    const size_t idx = it->second;
+    const size_t last = _data.size() - 1;
+    _handle_to_idx.erase(it);
+
+    // move the last object into the hole
+    if (idx != last) {
+        for (std::vector<float> *v :
+             {&_position_x, &_position_y, &_prev_position_x, &_prev_position_y,
+              &_force_x, &_force_y, &_acceleration_x, &_acceleration_y,
+              &_inv_mass}) {
+            (*v)[idx] = (*v)[last];
+        }
+        _data[idx] = _data[last];
+        _idx_to_handle[idx] = _idx_to_handle[last];
+        _handle_to_idx[_idx_to_handle[idx]] = uint32_t(idx);
+    }
+
+    // the last slot becomes padding
+    for (std::vector<float> *v :
+         {&_position_x, &_position_y, &_prev_position_x, &_prev_position_y,
+          &_force_x, &_force_y, &_acceleration_x, &_acceleration_y,
+          &_inv_mass}) {
+        (*v)[last] = 0.0f;
+    }
+    _data.pop_back();
+    _idx_to_handle.pop_back();
+}
+
+void PhysicsObjectStore::integrate(size_t begin, size_t end,
+                                   const glm::vec2 &global_force,
+                                   const glm::vec2 &gravity, float dt) {
+    // whole blocks, the padding past the last object is static
+    const float dt2 = dt * dt;
+    for (size_t i = begin; i < end; i += LANES) {
+#if defined(__AVX2__)
+        const __m256 inv_mass = _mm256_loadu_ps(&_inv_mass[i]);
+        const __m256 dynamic =
+            _mm256_cmp_ps(inv_mass, _mm256_setzero_ps(), _CMP_GT_OQ);
+        const __m256 vdt2 = _mm256_set1_ps(dt2);
+        const __m256 gfx = _mm256_set1_ps(global_force.x);
+        const __m256 gfy = _mm256_set1_ps(global_force.y);
+        const __m256 gx = _mm256_set1_ps(gravity.x);
+        const __m256 gy = _mm256_set1_ps(gravity.y);
+
+        const __m256 fx = _mm256_loadu_ps(&_force_x[i]);
+        const __m256 fy = _mm256_loadu_ps(&_force_y[i]);
+        const __m256 ax =
+            _mm256_add_ps(_mm256_mul_ps(_mm256_add_ps(fx, gfx), inv_mass), gx);
+        const __m256 ay =
+            _mm256_add_ps(_mm256_mul_ps(_mm256_add_ps(fy, gfy), inv_mass), gy);
+
+        const __m256 px = _mm256_loadu_ps(&_position_x[i]);
+        const __m256 py = _mm256_loadu_ps(&_position_y[i]);
+        const __m256 qx = _mm256_loadu_ps(&_prev_position_x[i]);
+        const __m256 qy = _mm256_loadu_ps(&_prev_position_y[i]);
+        const __m256 nx = _mm256_add_ps(
+            _mm256_add_ps(px, _mm256_sub_ps(px, qx)), _mm256_mul_ps(ax, vdt2));
+        const __m256 ny = _mm256_add_ps(
+            _mm256_add_ps(py, _mm256_sub_ps(py, qy)), _mm256_mul_ps(ay, vdt2));
+
+        // static objects keep their state
+        _mm256_storeu_ps(&_position_x[i], _mm256_blendv_ps(px, nx, dynamic));
+        _mm256_storeu_ps(&_position_y[i], _mm256_blendv_ps(py, ny, dynamic));
+        _mm256_storeu_ps(&_prev_position_x[i],
+                         _mm256_blendv_ps(qx, px, dynamic));
+        _mm256_storeu_ps(&_prev_position_y[i],
+                         _mm256_blendv_ps(qy, py, dynamic));
+        _mm256_storeu_ps(
+            &_acceleration_x[i],
+            _mm256_blendv_ps(_mm256_loadu_ps(&_acceleration_x[i]), ax, dynamic));
+        _mm256_storeu_ps(
+            &_acceleration_y[i],
+            _mm256_blendv_ps(_mm256_loadu_ps(&_acceleration_y[i]), ay, dynamic));
+        _mm256_storeu_ps(&_force_x[i], _mm256_andnot_ps(dynamic, fx));
+        _mm256_storeu_ps(&_force_y[i], _mm256_andnot_ps(dynamic, fy));
+#elif defined(__SSE2__) || defined(_M_X64)
+        // SSE2 has no blend: select with and/andnot/or
+        const auto select = [](__m128 a, __m128 b, __m128 mask) {
+            return _mm_or_ps(_mm_andnot_ps(mask, a), _mm_and_ps(mask, b));
+        };
+        for (size_t h = i; h < i + LANES; h += 4) {
+            const __m128 inv_mass = _mm_loadu_ps(&_inv_mass[h]);
+            const __m128 dynamic = _mm_cmpgt_ps(inv_mass, _mm_setzero_ps());
+            const __m128 vdt2 = _mm_set1_ps(dt2);
+
+            const __m128 fx = _mm_loadu_ps(&_force_x[h]);
+            const __m128 fy = _mm_loadu_ps(&_force_y[h]);
+            const __m128 ax = _mm_add_ps(
+                _mm_mul_ps(_mm_add_ps(fx, _mm_set1_ps(global_force.x)),
+                           inv_mass),
+                _mm_set1_ps(gravity.x));
+            const __m128 ay = _mm_add_ps(
+                _mm_mul_ps(_mm_add_ps(fy, _mm_set1_ps(global_force.y)),
+                           inv_mass),
+                _mm_set1_ps(gravity.y));
+
+            const __m128 px = _mm_loadu_ps(&_position_x[h]);
+            const __m128 py = _mm_loadu_ps(&_position_y[h]);
+            const __m128 qx = _mm_loadu_ps(&_prev_position_x[h]);
+            const __m128 qy = _mm_loadu_ps(&_prev_position_y[h]);
+            const __m128 nx = _mm_add_ps(_mm_add_ps(px, _mm_sub_ps(px, qx)),
+                                         _mm_mul_ps(ax, vdt2));
+            const __m128 ny = _mm_add_ps(_mm_add_ps(py, _mm_sub_ps(py, qy)),
+                                         _mm_mul_ps(ay, vdt2));
+
+            // static objects keep their state
+            _mm_storeu_ps(&_position_x[h], select(px, nx, dynamic));
+            _mm_storeu_ps(&_position_y[h], select(py, ny, dynamic));
+            _mm_storeu_ps(&_prev_position_x[h], select(qx, px, dynamic));
+            _mm_storeu_ps(&_prev_position_y[h], select(qy, py, dynamic));
+            _mm_storeu_ps(&_acceleration_x[h],
+                          select(_mm_loadu_ps(&_acceleration_x[h]), ax,
+                                 dynamic));
+            _mm_storeu_ps(&_acceleration_y[h],
+                          select(_mm_loadu_ps(&_acceleration_y[h]), ay,
+                                 dynamic));
+            _mm_storeu_ps(&_force_x[h], _mm_andnot_ps(dynamic, fx));
+            _mm_storeu_ps(&_force_y[h], _mm_andnot_ps(dynamic, fy));
+        }
+#else
+        for (size_t h = i; h < i + LANES; h++) {
+            if (_inv_mass[h] <= 0) {
+                continue; // static object
+            }
+            const float ax =
+                (_force_x[h] + global_force.x) * _inv_mass[h] + gravity.x;
+            const float ay =
+                (_force_y[h] + global_force.y) * _inv_mass[h] + gravity.y;
+            const float px = _position_x[h];
+            const float py = _position_y[h];
+            _position_x[h] = (px + (px - _prev_position_x[h])) + ax * dt2;
+            _position_y[h] = (py + (py - _prev_position_y[h])) + ay * dt2;
+            _prev_position_x[h] = px;
+            _prev_position_y[h] = py;
+            _acceleration_x[h] = ax;
+            _acceleration_y[h] = ay;
+            _force_x[h] = 0.0f;
+            _force_y[h] = 0.0f;
+        }
+#endif
+    }
+}
+
+} // namespace zo
@@ -0,0 +1,119 @@
+/**
+ * @file physics_object_store.hpp
+ * @author Micah Pearlman (micahpearlman@gmail.com)
+ * @brief Structure of arrays physics object storage.
+ * @version 0.1
+ * @date 2024-11-08
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#ifndef __zoPhysicsObjectStore_h__
+#define __zoPhysicsObjectStore_h__
+#include "physics_object_2d_impl.hpp"
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace zo {
+
+/// @brief Physics object storage.
+/// The state the integrator touches every step (position, previous position,
+/// force, acceleration and inverse mass) is kept as a structure of arrays of
+/// floats, the rest (PhysicsObject2dImpl::Data) as an array of structures.
+/// Objects are densely packed, removal moves the last object into the hole,
+/// and handles map to the dense index like ComponentStore.
+class PhysicsObjectStore {
+  public:
+    using handle_t = uint32_t;
+
+    /// @brief number of bodies integrate() processes per SIMD iteration
+    static constexpr size_t LANES = 8;
+
+    /// @brief Add an object at the origin with unit mass
+    /// @return the handle of the object
+    handle_t add();
+
+    /// @brief Remove an object.  Does nothing if the handle is not valid.
+    void remove(handle_t hndl);
+
+    bool contains(handle_t hndl) const {
+        return _handle_to_idx.contains(hndl);
+    }
+
+    /// @brief Get the dense index of a valid handle
+    uint32_t index(handle_t hndl) const { return _handle_to_idx.at(hndl); }
+
+    size_t size() const { return _data.size(); }
+
+    glm::vec2 position(size_t i) const {
+        return {_position_x[i], _position_y[i]};
+    }
+    void setPosition(size_t i, const glm::vec2 &p) {
+        _position_x[i] = p.x;
+        _position_y[i] = p.y;
+    }
+
+    glm::vec2 prevPosition(size_t i) const {
+        return {_prev_position_x[i], _prev_position_y[i]};
+    }
+    void setPrevPosition(size_t i, const glm::vec2 &p) {
+        _prev_position_x[i] = p.x;
+        _prev_position_y[i] = p.y;
+    }
+
+    glm::vec2 force(size_t i) const { return {_force_x[i], _force_y[i]}; }
+    void      setForce(size_t i, const glm::vec2 &f) {
+        _force_x[i] = f.x;
+        _force_y[i] = f.y;
+    }
+
+    glm::vec2 acceleration(size_t i) const {
+        return {_acceleration_x[i], _acceleration_y[i]};
+    }
+    void setAcceleration(size_t i, const glm::vec2 &a) {
+        _acceleration_x[i] = a.x;
+        _acceleration_y[i] = a.y;
+    }
+
+    /// @brief Set the mass.  A mass <= 0 is static (inverse mass 0).
+    void setMass(size_t i, float mass) {
+        _data[i].mass = mass;
+        _inv_mass[i] = mass > 0 ? 1.0f / mass : 0.0f;
+    }
+    float inverseMass(size_t i) const { return _inv_mass[i]; }
+
+    /// @brief The rest of the object state
+    PhysicsObject2dImpl::Data       &data(size_t i) { return _data[i]; }
+    const PhysicsObject2dImpl::Data &data(size_t i) const { return _data[i]; }
+
+    /// @brief Verlet integrate the dynamic objects in [begin, end):
+    ///   a = (force + global_force) / mass + gravity
+    ///   x(t+dt) = x(t) + (x(t) - x(t-dt)) + a * dt^2
+    /// then zero their forces.  Static objects (inverse mass 0) are left
+    /// untouched.  Runs LANES objects at a time (AVX2, SSE2 or scalar), an
+    /// object's result does not depend on the range it is integrated in as
+    /// long as range boundaries are multiples of LANES.
+    void integrate(size_t begin, size_t end, const glm::vec2 &global_force,
+                   const glm::vec2 &gravity, float dt);
+
+  private:
+    std::vector<float> _position_x;
+    std::vector<float> _position_y;
+    std::vector<float> _prev_position_x;
+    std::vector<float> _prev_position_y;
+    std::vector<float> _force_x;
+    std::vector<float> _force_y;
+    std::vector<float> _acceleration_x;
+    std::vector<float> _acceleration_y;
+    std::vector<float> _inv_mass;
+
+    std::vector<PhysicsObject2dImpl::Data> _data;
+
+    std::unordered_map<handle_t, uint32_t> _handle_to_idx;
+    std::vector<handle_t>                  _idx_to_handle;
+    handle_t                               _next_handle = 0;
+};
+
+} // namespace zo
+#endif // __zoPhysicsObjectStore_h__
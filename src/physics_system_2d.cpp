@@ -10,27 +10,36 @@
  */
 #include "physics_system_2d_impl.hpp"
 #include "physics_object_2d_impl.hpp"
+#include <zero_physics/math.hpp>
+#include <algorithm>
+#include <bit>
 #include <iostream>
+#include <stdexcept>
 
 namespace zo {
 
 std::shared_ptr<PhysicsSystem2d>
 PhysicsSystem2d::create(size_t max_num_objects, int iterations,
-                        BroadPhaseType broad_phase_type) {
+                        BroadPhaseType              broad_phase_type,
+                        const broad_phase_config_t &broad_phase_config,
+                        size_t                      num_threads) {
     PhysicsSystem2dImpl *impl =
-        new PhysicsSystem2dImpl(max_num_objects, iterations, broad_phase_type);
+        new PhysicsSystem2dImpl(max_num_objects, iterations, broad_phase_type,
+                                broad_phase_config, num_threads);
     return std::shared_ptr<PhysicsSystem2d>(impl);
 }
 
-PhysicsSystem2dImpl::PhysicsSystem2dImpl(size_t         max_number_object,
-                                         float          iterations,
-                                         BroadPhaseType broad_phase_type)
-    : _iterations(iterations) {
+PhysicsSystem2dImpl::PhysicsSystem2dImpl(
+    size_t max_number_object, float iterations, BroadPhaseType broad_phase_type,
+    const broad_phase_config_t &broad_phase_config, size_t num_threads)
+    : _iterations(iterations),
+      _swept_aabb_threshold(broad_phase_config.swept_aabb_threshold) {
     // create the collision system
     // HARDWIRED: the collision system colliders is 3 times the number of
     // physics objects
     std::shared_ptr<CollisionSystem2d> collision_sys =
-        CollisionSystem2d::create(max_number_object * 3, broad_phase_type);
+        CollisionSystem2d::create(max_number_object * 3, broad_phase_type,
+                                  broad_phase_config, num_threads);
     _collision_system =
         std::static_pointer_cast<CollisionSystem2dImpl>(collision_sys);
 }
@@ -42,241 +51,688 @@ void PhysicsSystem2dImpl::update(float dt) {
     for (const glm::vec2 &f : _global_forces) {
         global_force_sum += f;
     }
-    for (int i = 0; i < _iterations; i++) {
-        float iter_dt = dt / float(_iterations);
-        for (PhysicsObject2dImpl::Data &data : _physics_objects) {
-            if (data.mass <= 0) { // static object
-                continue;
-            }
 
-            /// Do the Verlet integration:
-            /// x(t+dt) = x(t) + (x(t) - x(t-dt)) + a(t) * dt^2
-            glm::vec2 force = data.force;
-            force += global_force_sum;
-            glm::vec2 acceleration = (force / data.mass) + gravity();            
-            glm::vec2 new_position = data.position +
-                                     (data.position - data.prev_position) +
-                                     acceleration * iter_dt * iter_dt;
-            data.prev_position = data.position;
-            data.position = new_position;
-            data.acceleration = acceleration;
-            data.force = glm::vec2(0);
-
-            // update the collider position
-            if (data.collider.type != uint16_t(ColliderType::MAX)) {
-
-                if (data.collider.type == uint8_t(ColliderType::CIRCLE)) {
-                    auto &collider =
-                        _collision_system
-                            ->getColliderData<CircleCollider2dImpl::Data>(
-                                data.collider);
-                    collider.circle.center = data.position;
-
-                    // update the aabb
-                    collider.aabb.mn = collider.circle.center -
-                                       glm::vec2{collider.circle.radius,
-                                                 collider.circle.radius};
-                    collider.aabb.mx = collider.circle.center +
-                                       glm::vec2{collider.circle.radius,
-                                                 collider.circle.radius};
-                } else if (data.collider.type == uint8_t(ColliderType::LINE)) {
-                    auto &collider =
-                        _collision_system
-                            ->getColliderData<LineCollider2dImpl::Data>(
-                                data.collider);
-                    if (data.collider_vertex == 0) {
-                        collider.line.line.start = data.position;
-                    } else {
-                        collider.line.line.end = data.position;
-                    }
-
-                    // update the aabb
-                    const glm::vec2 thickness =
-                        glm::vec2{collider.line.radius, collider.line.radius};
-                    collider.aabb.mn =
-                        glm::min(collider.line.line.start - thickness,
-                                 collider.line.line.end + thickness);
-                    collider.aabb.mx =
-                        glm::max(collider.line.line.start - thickness,
-                                 collider.line.line.end + thickness);
-                }
-            }
+    const float iter_dt = dt / float(_iterations);
+    if (_sub_stepping == false) {
+        // integrate all the iterations, then collide once
+        moveObjects(iter_dt, _iterations, 0, global_force_sum);
+        _collision_system->generateCollisionPairs();
+        resolveCollisions();
+        return;
+    }
+
+    // collide and resolve every sub-step.  Only the first sub-step runs the
+    // broad phase, with the aabbs inflated by the motion of the remaining
+    // sub-steps, the others narrow phase its pairs again.
+    for (int i = 0; i < _iterations; i++) {
+        if (i == 0) {
+            moveObjects(iter_dt, 1, _iterations - 1, global_force_sum);
+            _collision_system->generateCollisionPairs();
+        } else {
+            moveObjects(iter_dt, 1, 0, global_force_sum);
+            _collision_system->updateCollisionPairs();
         }
+        resolveCollisions();
     }
+}
 
-    // update the collision system
-    _collision_system->generateCollisionPairs();
+void PhysicsSystem2dImpl::moveObjects(float dt, int num_steps,
+                                      int              inflate_steps,
+                                      const glm::vec2 &global_force_sum) {
+    // integrate and update the colliders in parallel.  Objects are
+    // independent and the ranges are whole blocks of simd lanes, so the
+    // result is the same for any number of threads.
+    const size_t num_objects = _physics_objects.size();
+    const size_t lanes = PhysicsObjectStore::LANES;
+    _step_start_positions.resize(num_objects);
+    WorkerPool &pool = _collision_system->workerPool();
+    _thread_lines.resize(pool.numThreads());
+    pool.parallelFor((num_objects + lanes - 1) / lanes,
+                     [&](size_t block_begin, size_t block_end, size_t worker) {
+                         const size_t begin = block_begin * lanes;
+                         const size_t end =
+                             std::min(block_end * lanes, num_objects);
+                         integrate(begin, end, global_force_sum, dt, num_steps);
+                         updateColliders(begin, end, dt, inflate_steps,
+                                         _thread_lines[worker]);
+                     });
+
+    // a line collider is shared by the physics objects at its two vertices,
+    // update its aabb once both have moved, then inflate it by the motion of
+    // either
+    for (std::vector<LineUpdate> &lines : _thread_lines) {
+        for (const LineUpdate &update : lines) {
+            auto &collider =
+                _collision_system->getColliderData<LineCollider2dImpl::Data>(
+                    update.collider);
+            const glm::vec2 thickness =
+                glm::vec2{collider.line.radius, collider.line.radius};
+            collider.aabb.mn =
+                glm::min(collider.line.line.start, collider.line.line.end) -
+                thickness;
+            collider.aabb.mx =
+                glm::max(collider.line.line.start, collider.line.line.end) +
+                thickness;
+        }
+    }
+    for (std::vector<LineUpdate> &lines : _thread_lines) {
+        for (const LineUpdate &update : lines) {
+            auto &collider =
+                _collision_system->getColliderData<LineCollider2dImpl::Data>(
+                    update.collider);
+            const glm::vec2 margin = glm::vec2{update.margin, update.margin};
+            const glm::vec2 thickness =
+                glm::vec2{collider.line.radius, collider.line.radius};
+            collider.aabb.mn = glm::min(
+                collider.aabb.mn,
+                glm::min(collider.line.line.start, collider.line.line.end) -
+                    thickness - margin);
+            collider.aabb.mx = glm::max(
+                collider.aabb.mx,
+                glm::max(collider.line.line.start, collider.line.line.end) +
+                    thickness + margin);
+        }
+        lines.clear();
+    }
+}
 
-    // resolve collisions
-    for (const CollisionPair &pair : _collision_system->collisionPairs()) {
-        auto phy_obj_a = physicsObjectMappedToCollider(pair.a);
-        auto phy_obj_b = physicsObjectMappedToCollider(pair.b);
+void PhysicsSystem2dImpl::resolveCollisions() {
+    // look up the dynamic objects of the contacts.  The mapping is not
+    // thread safe so it is done up front for all the contacts.
+    const std::vector<CollisionPair> &pairs =
+        _collision_system->collisionPairs();
+    // the contacts with a static collider (floors, walls) are solved last,
+    // so the contacts between dynamic objects cannot push the objects back
+    // into them
+    _contacts.clear();
+    _static_contacts.clear();
+    for (size_t i = 0; i < pairs.size(); i++) {
+        const uint32_t a = dynamicObjectIndex(pairs[i].a);
+        const uint32_t b = dynamicObjectIndex(pairs[i].b);
 
-        // if both objects do not have physics objects then skip
-        if (phy_obj_a.has_value() == false && phy_obj_b.has_value() == false) {
+        // if both objects are static then skip
+        if (a == NO_OBJECT && b == NO_OBJECT) {
             continue;
         }
+        if (a == NO_OBJECT || b == NO_OBJECT) {
+            _static_contacts.push_back({uint32_t(i), a, b});
+        } else {
+            _contacts.push_back({uint32_t(i), a, b});
+        }
+    }
 
-        float     inv_mass_a = 0;
-        float     inv_mass_b = 0;
-        glm::vec2 velocity_a(0);
-        glm::vec2 velocity_b(0);
-        bool      is_static_a = false;
-        bool      is_static_b = false;
-
-        if (phy_obj_a.has_value()) {
-            const PhysicsObject2dImpl::Data &data =
-                physicsObjectData(phy_obj_a.value());
-
-            // not static
-            if (data.mass > 0) {
-                velocity_a = data.position - data.prev_position;
-                inv_mass_a = 1.0f / data.mass;
-            } else {
-                inv_mass_a = 0;
-                is_static_a = true;
+    _contacts.insert(_contacts.end(), _static_contacts.begin(),
+                     _static_contacts.end());
+    rewindSweptObjects(pairs);
+
+    // SEQUENTIAL solves the contacts in order.  GRAPH_COLORED solves the
+    // colors one after the other and the contacts of a color in parallel,
+    // no two contacts of a color share a dynamic object.
+    std::vector<SolverContact> *contacts = &_contacts;
+    if (_contact_solver_type == ContactSolverType::GRAPH_COLORED) {
+        colorContacts();
+        contacts = &_colored_contacts;
+    }
+    WorkerPool &pool = _collision_system->workerPool();
+    const auto  solve = [&](auto &&solve_contact) {
+        if (_contact_solver_type == ContactSolverType::SEQUENTIAL) {
+            for (SolverContact &contact : *contacts) {
+                solve_contact(pairs[contact.pair], contact);
             }
-        } else {
-            // static collision only object so make it's mass infinite
-            inv_mass_a = 0;
-            is_static_a = true;
+            return;
+        }
+        for (size_t color = 0; color < MAX_CONTACT_COLORS; color++) {
+            const size_t first = _color_offsets[color];
+            const size_t count = _color_offsets[color + 1] - first;
+            pool.parallelFor(count, [&](size_t begin, size_t end, size_t) {
+                for (size_t i = first + begin; i < first + end; i++) {
+                    SolverContact &contact = (*contacts)[i];
+                    solve_contact(pairs[contact.pair], contact);
+                }
+            });
         }
 
-        if (phy_obj_b.has_value()) {
-            const PhysicsObject2dImpl::Data &data =
-                physicsObjectData(phy_obj_b.value());
+        // the contacts that found every color taken
+        for (size_t i = _color_offsets[MAX_CONTACT_COLORS];
+             i < contacts->size(); i++) {
+            SolverContact &contact = (*contacts)[i];
+            solve_contact(pairs[contact.pair], contact);
+        }
+    };
 
-            // check if the object is static
-            if (data.mass > 0) {
-                inv_mass_b = 1.0f / data.mass;
-                velocity_b = data.position - data.prev_position;
-            } else {
-                // static object so make it's mass infinite
-                inv_mass_b = 0;
-                is_static_b = true;
+    // the positions the contact penetrations were measured at
+    if (_contact_solver_config.position_iterations > 0) {
+        _solve_start_positions.resize(_physics_objects.size());
+        for (size_t k = 0; k < _physics_objects.size(); k++) {
+            _solve_start_positions[k] = _physics_objects.position(k);
+        }
+    }
+
+    // start the contacts that persist from the last step with a fraction of
+    // their last impulse
+    const bool warm_starting = iterativeContactSolver() &&
+                               _contact_solver_config.warm_starting > 0;
+    if (warm_starting) {
+        solve([this](const CollisionPair &pair, SolverContact &contact) {
+            warmStartContact(pair, contact);
+        });
+    }
+    for (int i = 0; i < _contact_solver_config.velocity_iterations; i++) {
+        solve([this](const CollisionPair &pair, SolverContact &contact) {
+            solveContactVelocity(pair, contact);
+        });
+    }
+    for (int i = 0; i < _contact_solver_config.position_iterations; i++) {
+        solve([this](const CollisionPair &pair, SolverContact &contact) {
+            solveContactPosition(pair, contact);
+        });
+    }
+
+    _warm_start_impulses.clear();
+    if (warm_starting) {
+        for (const SolverContact &contact : *contacts) {
+            if (contact.impulse > 0) {
+                _warm_start_impulses[pairs[contact.pair].key()] =
+                    contact.impulse;
             }
-        } else {
-            inv_mass_b = 0;
-            is_static_b = true;
         }
+    }
+}
 
-        // if both objects are static then skip
-        if (is_static_a && is_static_b) {
-            continue;
+void PhysicsSystem2dImpl::setContactSolverConfig(
+    const contact_solver_config_t &config) {
+    if (config.velocity_iterations < 1) {
+        throw std::runtime_error("velocity_iterations must be at least 1");
+    }
+    if (config.position_iterations < 0) {
+        throw std::runtime_error("position_iterations must not be negative");
+    }
+    _contact_solver_config = config;
+}
+
+uint32_t PhysicsSystem2dImpl::dynamicObjectIndex(collider_handle_2d_t c_hndl) {
+    auto phy_obj = physicsObjectMappedToCollider(c_hndl);
+    if (phy_obj.has_value() == false) {
+        // static collision only object so make it's mass infinite
+        return NO_OBJECT;
+    }
+    const uint32_t index = _physics_objects.index(phy_obj.value());
+    if (_physics_objects.inverseMass(index) <= 0) {
+        // static object so make it's mass infinite
+        return NO_OBJECT;
+    }
+    return index;
+}
+
+void PhysicsSystem2dImpl::colorContacts() {
+    // greedy coloring in contact order: a contact takes the lowest color
+    // neither of its dynamic objects is in yet.  Static objects never
+    // conflict so the contacts with walls and floors are not serialized.
+    // The colors of an object are kept in a bit mask.
+    _object_colors.assign(_physics_objects.size(), 0);
+    _contact_colors.resize(_contacts.size());
+    _color_offsets.assign(MAX_CONTACT_COLORS + 2, 0);
+    for (size_t i = 0; i < _contacts.size(); i++) {
+        const SolverContact &contact = _contacts[i];
+        uint64_t             used = 0;
+        if (contact.a != NO_OBJECT) {
+            used |= _object_colors[contact.a];
+        }
+        if (contact.b != NO_OBJECT) {
+            used |= _object_colors[contact.b];
+        }
+        // a contact with a static object goes after the other contacts of
+        // its dynamic object, like in the collision pairs where the static
+        // pairs come last.  The last impulse then keeps the object out of
+        // the floors and walls.  MAX_CONTACT_COLORS if no color is left.
+        const bool has_static =
+            contact.a == NO_OBJECT || contact.b == NO_OBJECT;
+        const size_t color =
+            has_static ? MAX_CONTACT_COLORS - size_t(std::countl_zero(used))
+                       : size_t(std::countr_one(used));
+        if (color < MAX_CONTACT_COLORS) {
+            if (contact.a != NO_OBJECT) {
+                _object_colors[contact.a] |= uint64_t(1) << color;
+            }
+            if (contact.b != NO_OBJECT) {
+                _object_colors[contact.b] |= uint64_t(1) << color;
+            }
+        }
+        _contact_colors[i] = uint8_t(color);
+        _color_offsets[color + 1]++;
+    }
+
+    // counting sort by color.  It is stable so the contacts of a color keep
+    // the collision pair order.
+    for (size_t color = 0; color <= MAX_CONTACT_COLORS; color++) {
+        _color_offsets[color + 1] += _color_offsets[color];
+    }
+    _color_cursors.assign(_color_offsets.begin(), _color_offsets.end() - 1);
+    _colored_contacts.resize(_contacts.size());
+    for (size_t i = 0; i < _contacts.size(); i++) {
+        _colored_contacts[_color_cursors[_contact_colors[i]]++] = _contacts[i];
+    }
+}
+
+void PhysicsSystem2dImpl::solveContactVelocity(const CollisionPair &pair,
+                                               SolverContact       &contact) {
+    const uint32_t index_a = contact.a;
+    const uint32_t index_b = contact.b;
+    const bool     is_static_a = index_a == NO_OBJECT;
+    const bool     is_static_b = index_b == NO_OBJECT;
+    float      inv_mass_a = 0;
+    float      inv_mass_b = 0;
+    glm::vec2  velocity_a(0);
+    glm::vec2  velocity_b(0);
+    if (is_static_a == false) {
+        velocity_a = _physics_objects.position(index_a) -
+                     _physics_objects.prevPosition(index_a);
+        inv_mass_a = _physics_objects.inverseMass(index_a);
+    }
+    if (is_static_b == false) {
+        velocity_b = _physics_objects.position(index_b) -
+                     _physics_objects.prevPosition(index_b);
+        inv_mass_b = _physics_objects.inverseMass(index_b);
+    }
+
+    const Collider2dImpl::Data &col_data_a =
+        _collision_system->getBaseColliderData(pair.a);
+    const Collider2dImpl::Data &col_data_b =
+        _collision_system->getBaseColliderData(pair.b);
+
+    // calculate the relative velocities along the collision normal
+    // Vn = (Vb - Va) . N
+    // See full impulse calculation below.
+    const float Vn = glm::dot(velocity_b - velocity_a, pair.contact.normal);
+
+    // the following iterations correct the impulse of the first one
+    // (see below)
+    if (contact.solved) {
+        correctContactVelocity(pair, contact, inv_mass_a, inv_mass_b, Vn);
+        return;
+    }
+    contact.solved = true;
+
+    // if not already separating then resolve the collision by moving apart
+    // with an impulse.
+    float J = 0;
+    if (Vn < 0) {
+
+        // See: https://en.wikipedia.org/wiki/Collision_response
+        // See: https://en.wikipedia.org/wiki/Coefficient_of_restitution
+        // See: https://en.wikipedia.org/wiki/Impulse_(physics)
+        // See: https://en.wikipedia.org/wiki/Inelastic_collision
+        // https://physics.stackexchange.com/questions/598480/calculating-new-velocities-of-n-dimensional-particles-after-collision
+        //
+        // calculate the inelastic (i.e., with restitution) impulse
+        // magnitude:
+        //
+        //   Relative velocity along the collision normal:
+        //     Vn = (Vb - Va) . N
+        //
+        //          -(e + 1) * Vn
+        // J = -------------------------
+        //            1/ma + 1/mb
+        //
+        // where:
+        //   e is the coefficient of restitution
+        //   Vn is the relative velocity along the collision normal
+        //   Va is the velocity of object A
+        //   Vb is the velocity of object B
+        //   ma is the mass of object A
+        //   mb is the mass of object B
+        //   J is the impulse magnitude
+
+        // calculate the average of the two restitution values
+        const float e =
+            0.5f * (col_data_a.restitution + col_data_b.restitution);
+
+        // calculate impulse magnitude
+        J = -(e + 1.0) * Vn / (inv_mass_a + inv_mass_b);
+
+        // the target of the following iterations
+        contact.impulse += J;
+        contact.target_velocity = -e * Vn;
+
+    } else {
+        // objects are already separating
+        return;
+    }
+
+    // move apart
+    if (is_static_a == false) {
+        // the penetration is recovered by the position iterations, see
+        // solveContactPosition()
+
+        // apply impulse
+        // See: https://en.wikipedia.org/wiki/Collision_response
+        //
+        //  See the calculation of the impulse magnitude above.
+        //
+        //  Va' = Va - (J / ma) * N
+        //  where:
+        //      Va' is the new velocity of object A
+        //      Va is the current velocity of object A
+        //      N is the collision normal
+        //      J is the impulse magnitude (see above for calculation)
+        //      ma is the mass of object A
+        glm::vec2 Va_prime =
+            velocity_a - (J * inv_mass_a) * pair.contact.normal;
+
+        // update the previous position
+        // Remember that the velocity is implicit in the verlet integrator
+        // so we need to update the previous position to reflect the new
+        // velocity.  The iterative solver instead retakes the step with the
+        // new velocity, see correctContactVelocity(), unless the object was
+        // rewound to its time of impact (see rewindSweptObjects()).
+        // Retaking the step would undo the rewind.
+        if (iterativeContactSolver() && _rewind_tois[index_a] >= 1.0f) {
+            _physics_objects.setPosition(
+                index_a, _physics_objects.prevPosition(index_a) + Va_prime);
+        } else {
+            _physics_objects.setPrevPosition(
+                index_a, _physics_objects.position(index_a) - Va_prime);
         }
 
-        const Collider2dImpl::Data &col_data_a =
-            _collision_system->getBaseColliderData(pair.a);
-        const Collider2dImpl::Data &col_data_b =
-            _collision_system->getBaseColliderData(pair.b);
-
-        // calculate the relative velocities along the collision normal
-        // Vn = (Vb - Va) . N
-        // See full impulse calculation below.
-        const float Vn = glm::dot(velocity_b - velocity_a, pair.contact.normal);
-
-        // if not already separating then resolve the collision by moving apart
-        // with an impulse.
-        float J = 0;
-        if (Vn < 0) {
-
-            // See: https://en.wikipedia.org/wiki/Collision_response
-            // See: https://en.wikipedia.org/wiki/Coefficient_of_restitution
-            // See: https://en.wikipedia.org/wiki/Impulse_(physics)
-            // See: https://en.wikipedia.org/wiki/Inelastic_collision
-            // https://physics.stackexchange.com/questions/598480/calculating-new-velocities-of-n-dimensional-particles-after-collision
-            //
-            // calculate the inelastic (i.e., with restitution) impulse
-            // magnitude:
-            //
-            //   Relative velocity along the collision normal:
-            //     Vn = (Vb - Va) . N
-            //
-            //          -(e + 1) * Vn
-            // J = -------------------------
-            //            1/ma + 1/mb
-            //
-            // where:
-            //   e is the coefficient of restitution
-            //   Vn is the relative velocity along the collision normal
-            //   Va is the velocity of object A
-            //   Vb is the velocity of object B
-            //   ma is the mass of object A
-            //   mb is the mass of object B
-            //   J is the impulse magnitude
-
-            // calculate the average of the two restitution values
-            const float e =
-                0.5f * (col_data_a.restitution + col_data_b.restitution);
-
-            // calculate impulse magnitude
-            J = -(e + 1.0) * Vn / (inv_mass_a + inv_mass_b);
+        // data.prev_position = data.position; // DEBUG
+    }
 
+    if (is_static_b == false) {
+        // apply impulse
+        // See: https://en.wikipedia.org/wiki/Collision_response
+        //
+        //  See the calculation of the impulse magnitude above.
+        //
+        //  Vb' = Vb + (J / ma) * N
+        //  where:
+        //      Vb' is the new velocity of object B
+        //      Vb is the current velocity of object B
+        //      N is the collision normal
+        //      J is the impulse magnitude (see above for calculation)
+        //      ma is the mass of object A
+        glm::vec2 Vb_prime =
+            velocity_b + (J * inv_mass_b) * pair.contact.normal;
+
+        // update the previous position
+        // Remember that the velocity is implicit in the verlet integrator
+        // so we need to update the previous position to reflect the new
+        // velocity
+        if (iterativeContactSolver() && _rewind_tois[index_b] >= 1.0f) {
+            _physics_objects.setPosition(
+                index_b, _physics_objects.prevPosition(index_b) + Vb_prime);
         } else {
-            // objects are already separating
+            _physics_objects.setPrevPosition(
+                index_b, _physics_objects.position(index_b) - Vb_prime);
+        }
+
+        // data.prev_position = data.position; // DEBUG
+    }
+}
+
+void PhysicsSystem2dImpl::rewindSweptObjects(
+    const std::vector<CollisionPair> &pairs) {
+    // the earliest time of impact of the approaching contacts of each
+    // object.  Measured before any contact is solved, so an object hitting
+    // two colliders in a step is moved back once.
+    _rewind_tois.assign(_physics_objects.size(), 1.0f);
+    bool is_rewound = false;
+    for (const SolverContact &contact : _contacts) {
+        const CollisionPair &pair = pairs[contact.pair];
+        if (pair.toi >= 1.0f) {
             continue;
         }
+        glm::vec2 velocity(0);
+        for (const uint32_t index : {contact.a, contact.b}) {
+            if (index != NO_OBJECT) {
+                const glm::vec2 v = _physics_objects.position(index) -
+                                    _physics_objects.prevPosition(index);
+                velocity += index == contact.a ? -v : v;
+            }
+        }
+        if (glm::dot(velocity, pair.contact.normal) >= 0) {
+            continue; // separating
+        }
+        // only the swept side moved along a path
+        if (contact.a != NO_OBJECT &&
+            _collision_system->getBaseColliderData(pair.a).sweep !=
+                glm::vec2(0)) {
+            _rewind_tois[contact.a] = std::min(_rewind_tois[contact.a], pair.toi);
+            is_rewound = true;
+        }
+        if (contact.b != NO_OBJECT &&
+            _collision_system->getBaseColliderData(pair.b).sweep !=
+                glm::vec2(0)) {
+            _rewind_tois[contact.b] = std::min(_rewind_tois[contact.b], pair.toi);
+            is_rewound = true;
+        }
+    }
+    if (is_rewound == false) {
+        return;
+    }
 
-        // move apart
-        if (is_static_a == false && phy_obj_a.has_value()) {
-            PhysicsObject2dImpl::Data &data =
-                physicsObjectData(phy_obj_a.value());
-            // move apart by collision normal and penetration depth
-            // data.position += pair.contact.normal * (-pair.contact.penetration*0.5f);
-
-            // apply impulse
-            // See: https://en.wikipedia.org/wiki/Collision_response
-            //
-            //  See the calculation of the impulse magnitude above.
-            //
-            //  Va' = Va - (J / ma) * N
-            //  where:
-            //      Va' is the new velocity of object A
-            //      Va is the current velocity of object A
-            //      N is the collision normal
-            //      J is the impulse magnitude (see above for calculation)
-            //      ma is the mass of object A
-            glm::vec2 Va_prime =
-                velocity_a - (J * inv_mass_a) * pair.contact.normal;
-
-            // update the previous position
-            // Remember that the velocity is implicit in the verlet integrator
-            // so we need to update the previous position to reflect the new
-            // velocity
-            data.prev_position = data.position - Va_prime;
-
-            // data.prev_position = data.position; // DEBUG
+    // move the objects back to where they made contact
+    for (size_t k = 0; k < _physics_objects.size(); k++) {
+        const float toi = _rewind_tois[k];
+        if (toi < 1.0f) {
+            const Collider2dImpl::Data &collider =
+                _collision_system->getBaseColliderData(
+                    _physics_objects.data(k).collider);
+            rewindObject(k, collider.sweep * (1.0f - toi));
         }
+    }
+
+    // the contacts an object only makes after its time of impact are not
+    // reached in this step.  They are found again in the next one.
+    std::erase_if(_contacts, [&](const SolverContact &contact) {
+        const float toi = pairs[contact.pair].toi;
+        return (contact.a != NO_OBJECT && _rewind_tois[contact.a] < toi) ||
+               (contact.b != NO_OBJECT && _rewind_tois[contact.b] < toi);
+    });
+}
 
-        if (is_static_b == false && phy_obj_b.has_value()) {
-            PhysicsObject2dImpl::Data &data =
-                physicsObjectData(phy_obj_b.value());
-
-            // data.position += pair.contact.normal * (pair.contact.penetration * 0.5f);
-
-
-            // apply impulse
-            // See: https://en.wikipedia.org/wiki/Collision_response
-            //
-            //  See the calculation of the impulse magnitude above.
-            //
-            //  Vb' = Vb + (J / ma) * N
-            //  where:
-            //      Vb' is the new velocity of object B
-            //      Vb is the current velocity of object B
-            //      N is the collision normal
-            //      J is the impulse magnitude (see above for calculation)
-            //      ma is the mass of object A
-            glm::vec2 Vb_prime =
-                velocity_b + (J * inv_mass_b) * pair.contact.normal;
-
-            // update the previous position
-            // Remember that the velocity is implicit in the verlet integrator
-            // so we need to update the previous position to reflect the new
-            // velocity
-            data.prev_position = data.position - Vb_prime;
-
-            // data.prev_position = data.position; // DEBUG
+void PhysicsSystem2dImpl::rewindObject(size_t index, glm::vec2 distance) {
+    _physics_objects.setPosition(index,
+                                 _physics_objects.position(index) - distance);
+    _physics_objects.setPrevPosition(
+        index, _physics_objects.prevPosition(index) - distance);
+}
+
+void PhysicsSystem2dImpl::warmStartContact(const CollisionPair &pair,
+                                           SolverContact       &contact) {
+    auto it = _warm_start_impulses.find(pair.key());
+    if (it == _warm_start_impulses.end()) {
+        return;
+    }
+    const float J = _contact_solver_config.warm_starting * it->second;
+    contact.impulse = J;
+    if (contact.a != NO_OBJECT) {
+        _physics_objects.setPosition(
+            contact.a, _physics_objects.position(contact.a) -
+                           (J * _physics_objects.inverseMass(contact.a)) *
+                               pair.contact.normal);
+    }
+    if (contact.b != NO_OBJECT) {
+        _physics_objects.setPosition(
+            contact.b, _physics_objects.position(contact.b) +
+                           (J * _physics_objects.inverseMass(contact.b)) *
+                               pair.contact.normal);
+    }
+}
+
+void PhysicsSystem2dImpl::correctContactVelocity(const CollisionPair &pair,
+                                                 SolverContact &contact,
+                                                 float inv_mass_a,
+                                                 float inv_mass_b, float Vn) {
+    // projected Gauss-Seidel: the other contacts of the objects changed
+    // their velocities since the last iteration.  Apply the impulse that
+    // takes Vn to the target velocity of the first iteration, keeping the
+    // accumulated impulse >= 0 so contacts only ever push.
+    //
+    //  dJ = (Vt - Vn) / (1/ma + 1/mb)
+    //  J' = max(J + dJ, 0)
+    //
+    // The velocity is the displacement of the step.  The position is moved
+    // instead of the previous position, i.e., the step is retaken with the
+    // new velocity, so the objects do not keep the penetration the
+    // integration caused and the following contacts see where they are.
+    float J = (contact.target_velocity - Vn) / (inv_mass_a + inv_mass_b);
+    J = std::max(contact.impulse + J, 0.0f) - contact.impulse;
+    if (J == 0) {
+        return;
+    }
+    contact.impulse += J;
+
+    if (contact.a != NO_OBJECT) {
+        _physics_objects.setPosition(
+            contact.a, _physics_objects.position(contact.a) -
+                           (J * inv_mass_a) * pair.contact.normal);
+    }
+    if (contact.b != NO_OBJECT) {
+        _physics_objects.setPosition(
+            contact.b, _physics_objects.position(contact.b) +
+                           (J * inv_mass_b) * pair.contact.normal);
+    }
+}
+
+void PhysicsSystem2dImpl::solveContactPosition(const CollisionPair &pair,
+                                               SolverContact       &contact) {
+    float     inv_mass_a = 0;
+    float     inv_mass_b = 0;
+    glm::vec2 correction_a(0);
+    glm::vec2 correction_b(0);
+    if (contact.a != NO_OBJECT) {
+        inv_mass_a = _physics_objects.inverseMass(contact.a);
+        correction_a = _physics_objects.position(contact.a) -
+                       _solve_start_positions[contact.a];
+    }
+    if (contact.b != NO_OBJECT) {
+        inv_mass_b = _physics_objects.inverseMass(contact.b);
+        correction_b = _physics_objects.position(contact.b) -
+                       _solve_start_positions[contact.b];
+    }
+
+    // the penetration left after the objects moved so far
+    const float penetration =
+        pair.contact.penetration -
+        glm::dot(correction_b - correction_a, pair.contact.normal);
+
+    // Baumgarte: remove a fraction of the penetration beyond the slop each
+    // iteration, split between the objects by their inverse masses
+    const float C = _contact_solver_config.baumgarte *
+                    (penetration - _contact_solver_config.linear_slop);
+    if (C <= 0) {
+        return;
+    }
+    const float     P = C / (inv_mass_a + inv_mass_b);
+    const glm::vec2 normal = pair.contact.normal;
+
+    // move the previous position along so no velocity is added
+    if (contact.a != NO_OBJECT) {
+        const glm::vec2 d = -(P * inv_mass_a) * normal;
+        _physics_objects.setPosition(contact.a,
+                                     _physics_objects.position(contact.a) + d);
+        _physics_objects.setPrevPosition(
+            contact.a, _physics_objects.prevPosition(contact.a) + d);
+    }
+    if (contact.b != NO_OBJECT) {
+        const glm::vec2 d = (P * inv_mass_b) * normal;
+        _physics_objects.setPosition(contact.b,
+                                     _physics_objects.position(contact.b) + d);
+        _physics_objects.setPrevPosition(
+            contact.b, _physics_objects.prevPosition(contact.b) + d);
+    }
+}
+
+void PhysicsSystem2dImpl::integrate(size_t begin, size_t end,
+                                    const glm::vec2 &global_force_sum,
+                                    float dt, int num_steps) {
+    for (size_t k = begin; k < end; k++) {
+        _step_start_positions[k] = _physics_objects.position(k);
+    }
+    for (int i = 0; i < num_steps; i++) {
+        /// Do the Verlet integration:
+        /// x(t+dt) = x(t) + (x(t) - x(t-dt)) + a(t) * dt^2
+        _physics_objects.integrate(begin, end, global_force_sum, gravity(),
+                                   dt);
+    }
+}
+
+float PhysicsSystem2dImpl::motionBound(size_t k, float dt,
+                                       int num_steps) const {
+    if (num_steps <= 0) {
+        return 0.0f;
+    }
+    // with a constant acceleration a and the last displacement d the object
+    // moves n d + a dt^2 n (n + 1) / 2 in the next n steps
+    const float n = float(num_steps);
+    return n * glm::length(_physics_objects.position(k) -
+                           _physics_objects.prevPosition(k)) +
+           glm::length(_physics_objects.acceleration(k)) * dt * dt * n *
+               (n + 1.0f) * 0.5f;
+}
+
+void PhysicsSystem2dImpl::updateColliders(size_t begin, size_t end, float dt,
+                                          int                      inflate_steps,
+                                          std::vector<LineUpdate> &lines) {
+    for (size_t k = begin; k < end; k++) {
+        const PhysicsObject2dImpl::Data &data = _physics_objects.data(k);
+        if (data.mass <= 0 ||
+            data.collider.type == uint16_t(ColliderType::MAX)) {
+            continue;
+        }
+        const glm::vec2 position = _physics_objects.position(k);
+        const glm::vec2 step_start = _step_start_positions[k];
+        const float     margin = motionBound(k, dt, inflate_steps);
+
+        if (data.collider.type == uint8_t(ColliderType::CIRCLE)) {
+            auto &collider =
+                _collision_system->getColliderData<CircleCollider2dImpl::Data>(
+                    data.collider);
+            collider.circle.center = position;
+
+            // update the aabb
+            collider.aabb.mn = collider.circle.center -
+                               glm::vec2{collider.circle.radius,
+                                         collider.circle.radius};
+            collider.aabb.mx = collider.circle.center +
+                               glm::vec2{collider.circle.radius,
+                                         collider.circle.radius};
+
+            // sweep the aabb of bullets and fast movers back to the start of
+            // the step.  The narrow phase finds their time of impact.
+            collider.sweep = glm::vec2(0);
+            const glm::vec2 sweep = position - step_start;
+            const float     distance = glm::length(sweep);
+            const bool      fast = _swept_aabb_threshold >= 0 &&
+                              distance >
+                                  _swept_aabb_threshold * collider.circle.radius;
+            if ((data.is_bullet && distance > EPSILON) || fast) {
+                collider.sweep = sweep;
+                collider.aabb.mn = glm::min(collider.aabb.mn,
+                                            collider.aabb.mn - sweep);
+                collider.aabb.mx = glm::max(collider.aabb.mx,
+                                            collider.aabb.mx - sweep);
+            }
+            collider.aabb.mn -= glm::vec2(margin);
+            collider.aabb.mx += glm::vec2(margin);
+        } else if (data.collider.type == uint8_t(ColliderType::LINE)) {
+            auto &collider =
+                _collision_system->getColliderData<LineCollider2dImpl::Data>(
+                    data.collider);
+            if (data.collider_vertex == 0) {
+                collider.line.line.start = position;
+            } else {
+                collider.line.line.end = position;
+            }
+            lines.push_back({data.collider, margin});
+        } else if (data.collider.type == uint8_t(ColliderType::BOX)) {
+            auto &collider =
+                _collision_system->getColliderData<BoxCollider2dImpl::Data>(
+                    data.collider);
+            collider.box.center = position;
+            collider.aabb = boxAabb(collider.box);
+            collider.aabb.mn -= glm::vec2(margin);
+            collider.aabb.mx += glm::vec2(margin);
         }
     }
 }
@@ -299,19 +755,19 @@ const ComponentStore<glm::vec2> &PhysicsSystem2dImpl::globalForces() const {
 }
 
 std::unique_ptr<PhysicsObject2d> PhysicsSystem2dImpl::createPhysicsObject() {
-    PhysicsObject2dImpl::Data data;
-    phy_obj_handle_2d_t       hndl = _physics_objects.add(data);
+    phy_obj_handle_2d_t hndl = _physics_objects.add();
     return std::make_unique<PhysicsObject2dImpl>(*this, hndl);
 }
 
 void PhysicsSystem2dImpl::destroyPhysicsObject(phy_obj_handle_2d_t hndl) {
-    auto phy_data = _physics_objects.get(hndl);
-    if (phy_data.has_value() == false) {
+    if (_physics_objects.contains(hndl) == false) {
         return;
     }
-    PhysicsObject2dImpl::Data *data = &phy_data->get();
-    if (data->collider.index != 0xfffffff) {
-        _collision_system->destroyCollider(data->collider);
+    const PhysicsObject2dImpl::Data &data =
+        _physics_objects.data(_physics_objects.index(hndl));
+    if (data.collider.index != 0xfffffff) {
+        _collider_map.erase(data.collider.handle);
+        _collision_system->destroyCollider(data.collider);
     }
     _physics_objects.remove(hndl);
 }
@@ -323,7 +779,7 @@ void PhysicsSystem2dImpl::destroyPhysicsObject(
 }
 
 bool PhysicsSystem2dImpl::isPhysicsHandleValid(phy_obj_handle_2d_t hndl) const {
-    return _physics_objects.get(hndl).has_value();
+    return _physics_objects.contains(hndl);
 }
 
 } // namespace zo
\ No newline at end of file
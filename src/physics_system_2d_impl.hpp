@@ -14,12 +14,16 @@
 #include <zero_physics/physics_system_2d.hpp>
 #include <zero_physics/memory.hpp>
 #include "physics_object_2d_impl.hpp"
+#include "physics_object_store.hpp"
 #include "collision_system_2d_impl.hpp"
 
 namespace zo {
 class PhysicsSystem2dImpl : public PhysicsSystem2d {
   public:
-    PhysicsSystem2dImpl(size_t max_num_objects, float iterations, BroadPhaseType broad_phase_type);
+    PhysicsSystem2dImpl(size_t max_num_objects, float iterations,
+                        BroadPhaseType              broad_phase_type,
+                        const broad_phase_config_t &broad_phase_config,
+                        size_t                      num_threads);
     virtual ~PhysicsSystem2dImpl() = default;
 
     void update(float dt) override;
@@ -38,6 +42,23 @@ class PhysicsSystem2dImpl : public PhysicsSystem2d {
     void destroyPhysicsObject(phy_obj_handle_2d_t hndl) override;
     void destroyPhysicsObject(std::unique_ptr<PhysicsObject2d> &obj) override;
 
+    void setSubStepping(bool sub_stepping) override {
+        _sub_stepping = sub_stepping;
+    }
+    bool subStepping() const override { return _sub_stepping; }
+
+    void setContactSolverType(ContactSolverType type) override {
+        _contact_solver_type = type;
+    }
+    ContactSolverType contactSolverType() const override {
+        return _contact_solver_type;
+    }
+
+    void setContactSolverConfig(const contact_solver_config_t &config) override;
+    const contact_solver_config_t &contactSolverConfig() const override {
+        return _contact_solver_config;
+    }
+
     CollisionSystem2d &collisionSystem() override { return *_collision_system; }
 
   public: // Implementation specific
@@ -47,15 +68,13 @@ class PhysicsSystem2dImpl : public PhysicsSystem2d {
 
     /// @brief Get the physics object store
     /// @return The physics object store
-    ComponentStore<PhysicsObject2dImpl::Data> &physicsObjects() {
-        return _physics_objects;
-    }
+    PhysicsObjectStore &physicsObjects() { return _physics_objects; }
 
     /// @brief Get the physics object data from the handle
     /// @param hndl the handle
     /// @return PhysicsObject2dImpl::Data& the physics object data
     PhysicsObject2dImpl::Data &physicsObjectData(phy_obj_handle_2d_t hndl) {
-        return _physics_objects.get(hndl)->get();
+        return _physics_objects.data(_physics_objects.index(hndl));
     }
 
     /// @brief Map a collider to a physics object.
@@ -63,46 +82,227 @@ class PhysicsSystem2dImpl : public PhysicsSystem2d {
     /// @param p_hndl
     void mapColliderToPhysicsObject(collider_handle_2d_t c_hndl,
                                     phy_obj_handle_2d_t  p_hndl) {
-        _collider_map[c_hndl.handle] = p_hndl;
+        std::vector<phy_obj_handle_2d_t> &objects =
+            _collider_map[c_hndl.handle];
+        std::erase(objects, p_hndl);
+        objects.push_back(p_hndl);
+        syncColliderStatic(c_hndl);
     }
 
-    /// @brief Unmap a collider from a physics object.
+    /// @brief Tell the collision system if a collider is static, i.e., none
+    /// of the physics objects mapped to it is dynamic (mass > 0).
+    /// @param c_hndl the collider handle
+    void syncColliderStatic(collider_handle_2d_t c_hndl) {
+        if (c_hndl.type == uint8_t(ColliderType::MAX)) {
+            return;
+        }
+        bool is_static = true;
+        auto it = _collider_map.find(c_hndl.handle);
+        if (it != _collider_map.end()) {
+            for (phy_obj_handle_2d_t p_hndl : it->second) {
+                if (isPhysicsHandleValid(p_hndl) &&
+                    physicsObjectData(p_hndl).mass > 0) {
+                    is_static = false;
+                }
+            }
+        }
+        _collision_system->setColliderStatic(c_hndl, is_static);
+    }
+
+    /// @brief Unmap a collider from a physics object.  The collider becomes
+    /// static again if no dynamic physics object is left mapped to it.
     /// @param c_hndl
-    void unmapColliderFromPhysicsObject(collider_handle_2d_t c_hndl) {
-        if (_collider_map.contains(c_hndl.handle) == false) {
+    /// @param p_hndl
+    void unmapColliderFromPhysicsObject(collider_handle_2d_t c_hndl,
+                                        phy_obj_handle_2d_t  p_hndl) {
+        auto it = _collider_map.find(c_hndl.handle);
+        if (it == _collider_map.end()) {
             return;
         }
-        _collider_map.erase(c_hndl.handle);
+        std::erase(it->second, p_hndl);
+        if (it->second.empty()) {
+            _collider_map.erase(it);
+        }
+        syncColliderStatic(c_hndl);
     }
 
-    /// @brief Get the physics object from the collider handle
+    /// @brief Get the physics object from the collider handle.  For colliders
+    /// mapped to several physics objects (lines) the last one mapped.
     /// @param c_hndl
     /// @return phy_obj_handle_2d_t
     std::optional<phy_obj_handle_2d_t>
     physicsObjectMappedToCollider(collider_handle_2d_t c_hndl) {
-        if (_collider_map.contains(c_hndl.handle) == false) {
+        auto it = _collider_map.find(c_hndl.handle);
+        if (it == _collider_map.end()) {
             return std::nullopt;
         }
-        if (isPhysicsHandleValid(_collider_map[c_hndl.handle]) == false) {
-            _collider_map.erase(c_hndl.handle);
+        std::erase_if(it->second, [this](phy_obj_handle_2d_t p_hndl) {
+            return isPhysicsHandleValid(p_hndl) == false;
+        });
+        if (it->second.empty()) {
+            _collider_map.erase(it);
             return std::nullopt;
         }
-        return _collider_map[c_hndl.handle];
+        return it->second.back();
     }
 
+  private:
+    /// @brief A line collider moved by a physics object at one of its
+    /// vertices and the margin to inflate its aabb by
+    struct LineUpdate {
+        collider_handle_2d_t collider;
+        float                margin = 0.0f;
+    };
+
+    /// @brief Integrate the objects and update their colliders
+    /// @param dt the integration time step
+    /// @param num_steps the number of integration steps
+    /// @param inflate_steps inflate the collider aabbs by the motion of this
+    /// many following steps
+    /// @param global_force_sum the sum of the global forces
+    void moveObjects(float dt, int num_steps, int inflate_steps,
+                     const glm::vec2 &global_force_sum);
+
+    /// @brief object index of static objects and colliders without physics
+    /// objects
+    static constexpr uint32_t NO_OBJECT = 0xffffffff;
+
+    /// @brief number of colors of the graph colored contact solver, one bit
+    /// of an object's color mask each.  Contacts that find every color taken
+    /// are resolved serially last.
+    static constexpr size_t MAX_CONTACT_COLORS = 64;
+
+    /// @brief A contact to resolve
+    struct SolverContact {
+        /// @brief index of the collision pair
+        uint32_t pair = 0;
+        /// @brief indices of the dynamic objects, or NO_OBJECT
+        uint32_t a = NO_OBJECT;
+        uint32_t b = NO_OBJECT;
+        /// @brief accumulated impulse and the normal velocity the following
+        /// velocity iterations aim for
+        float impulse = 0.0f;
+        float target_velocity = 0.0f;
+        /// @brief true after the first velocity iteration
+        bool solved = false;
+    };
+
+    /// @brief Resolve the collision pairs of the collision system
+    void resolveCollisions();
+
+    /// @brief True if the contact solver iterates the velocities, false for
+    /// the single impulse per contact
+    bool iterativeContactSolver() const {
+        return _contact_solver_config.velocity_iterations > 1;
+    }
+
+    /// @brief Get the index of the dynamic physics object of a collider
+    /// @return the object index, NO_OBJECT if the collider has no physics
+    /// object or it is static
+    uint32_t dynamicObjectIndex(collider_handle_2d_t c_hndl);
+
+    /// @brief Sort the contacts into _colored_contacts by color
+    void colorContacts();
+
+    /// @brief Velocity iteration of a contact.  The first iteration applies
+    /// the restitution impulse, the following ones correct it.  Only writes
+    /// the two objects so contacts of different objects can be solved in
+    /// parallel.
+    /// @param pair the collision pair
+    /// @param contact the contact of the pair
+    void solveContactVelocity(const CollisionPair &pair,
+                              SolverContact       &contact);
+
+    /// @brief Move each dynamic object of a swept contact back along its
+    /// path, once, to the earliest time of impact of its approaching
+    /// contacts, and drop the contacts it only makes later in the step.
+    /// @param pairs the collision pairs of the contacts
+    void rewindSweptObjects(const std::vector<CollisionPair> &pairs);
+
+    /// @brief Move an object and its previous position back along its
+    /// path, keeping its velocity
+    /// @param index the object index in the physics object store
+    /// @param distance the distance to move back
+    void rewindObject(size_t index, glm::vec2 distance);
+
+    /// @brief Apply the warm starting fraction of the impulse a contact had
+    /// in the last step
+    void warmStartContact(const CollisionPair &pair, SolverContact &contact);
+
+    /// @brief Velocity iteration of a contact after the first
+    void correctContactVelocity(const CollisionPair &pair,
+                                SolverContact &contact, float inv_mass_a,
+                                float inv_mass_b, float Vn);
+
+    /// @brief Position iteration of a contact.  Pushes the objects apart by
+    /// the Baumgarte fraction of the penetration left.  Only writes the two
+    /// objects.
+    /// @param pair the collision pair
+    /// @param contact the contact of the pair
+    void solveContactPosition(const CollisionPair &pair,
+                              SolverContact       &contact);
+
+    /// @brief Verlet integrate the objects in [begin, end) num_steps times.
+    /// begin must be a multiple of PhysicsObjectStore::LANES.
+    void integrate(size_t begin, size_t end, const glm::vec2 &global_force_sum,
+                   float dt, int num_steps);
+
+    /// @brief Bound the distance object k moves in the next num_steps steps
+    /// of dt if its acceleration stays the same.  Impulses of contacts found
+    /// later are not accounted for.
+    float motionBound(size_t k, float dt, int num_steps) const;
+
+    /// @brief Move the colliders of the objects in [begin, end) to the
+    /// objects and update their aabbs, inflated by the motion of the next
+    /// inflate_steps steps.  Line colliders are shared by two objects so
+    /// they are only collected in lines for their aabbs to be updated after
+    /// all the objects have moved.
+    void updateColliders(size_t begin, size_t end, float dt, int inflate_steps,
+                         std::vector<LineUpdate> &lines);
+
   private:
     float                                     _last_time_step = 1 / 60.0f;
     int                                       _iterations = 1;
+    bool                                      _sub_stepping = false;
+    ContactSolverType _contact_solver_type = ContactSolverType::SEQUENTIAL;
+    contact_solver_config_t                   _contact_solver_config;
+    float                                     _swept_aabb_threshold = 1.0f;
+
+    // physics object positions at the start of the update
+    std::vector<glm::vec2> _step_start_positions;
+
+    // line colliders moved by each worker
+    std::vector<std::vector<LineUpdate>> _thread_lines;
+
+    // contacts of the collision pairs and their graph coloring
+    std::vector<SolverContact> _contacts;
+    std::vector<SolverContact> _static_contacts;
+    std::vector<uint64_t>      _object_colors;
+    std::vector<uint8_t>       _contact_colors;
+    std::vector<size_t>        _color_offsets;
+    std::vector<size_t>        _color_cursors;
+    std::vector<SolverContact> _colored_contacts;
+
+    // object positions at the start of the contact solve
+    std::vector<glm::vec2> _solve_start_positions;
+
+    // time of impact each object was moved back to in this step, 1 if it
+    // was not
+    std::vector<float> _rewind_tois;
+
+    // impulses of the contacts of the last step by CollisionPair::key()
+    std::unordered_map<uint64_t, float> _warm_start_impulses;
 
     glm::vec2                                 _gravity = {0, 0};
 
     ComponentStore<glm::vec2>                 _global_forces;
-    ComponentStore<PhysicsObject2dImpl::Data> _physics_objects;
+    PhysicsObjectStore                        _physics_objects;
 
     std::shared_ptr<CollisionSystem2dImpl> _collision_system;
 
-    // map collider to physics object
-    std::unordered_map<uint32_t, phy_obj_handle_2d_t> _collider_map;
+    // map collider to the physics objects moving it (two for lines)
+    std::unordered_map<uint32_t, std::vector<phy_obj_handle_2d_t>>
+        _collider_map;
 };
 
 } // namespace zo
@@ -0,0 +1,159 @@
+/**
+ * @file polyline.hpp
+ * @author Micah Pearlman (micahpearlman@gmail.com)
+ * @brief Collision of circles and boxes with thick polylines.
+ * @version 0.1
+ * @date 2024-11-06
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#ifndef __zoPhysicsPolyline_h__
+#define __zoPhysicsPolyline_h__
+#include <zero_physics/types.hpp>
+#include <zero_physics/math.hpp>
+#include <cstdint>
+
+namespace zo {
+
+// A polyline shape (ChainShape, HeightfieldShape) provides:
+//   thick_line_segment_2d_t segment(uint32_t i) const;
+//   bool neighbor(uint32_t i, bool start, uint32_t &j) const;
+//     the segment j sharing the start (or end) vertex of segment i
+//   void query(const aabb_2d_t &aabb, Callback &&callback) const;
+//     calls callback(uint32_t i) for the segments overlapping aabb
+//
+// Contacts of neighboring segments are smoothed at their shared vertex: a
+// vertex contact is dropped when the circle projects onto the neighboring
+// segment's side of the vertex, where the neighbor reports the contact
+// instead.  This stops circles rolling over a polyline from catching on the
+// internal vertices.
+
+/// @brief Check if the contact of a circle at p with the start (or end)
+/// vertex of segment i belongs to the neighboring segment sharing the
+/// vertex.
+template <typename Shape>
+bool neighborOwnsVertex(const Shape &shape, uint32_t i, bool start,
+                        const glm::vec2 &p) {
+    uint32_t j = 0;
+    if (shape.neighbor(i, start, j) == false) {
+        return false; // open end
+    }
+    const line_segment_2d_t n = shape.segment(j).line;
+    return start ? glm::dot(n.end - n.start, n.end - p) > 0
+                 : glm::dot(n.end - n.start, p - n.start) > 0;
+}
+
+/// @brief Collide a circle with a polyline
+/// @param shape the polyline
+/// @param c circle
+/// @param contact the smoothed contact if collision.  The normal points
+/// from the circle to the polyline.
+/// @return true if collision
+template <typename Shape>
+bool circleToPolyline(const Shape &shape, const circle_2d_t &c,
+                      contact_2d_t &contact) {
+    const glm::vec2 extent = {c.radius, c.radius};
+    float           deepest = -1.0f;
+    glm::vec2       normal_sum(0);
+    shape.query({c.center - extent, c.center + extent}, [&](uint32_t i) {
+        const thick_line_segment_2d_t seg = shape.segment(i);
+        const glm::vec2               d = seg.line.end - seg.line.start;
+        const float t = glm::dot(c.center - seg.line.start, d);
+
+        // a contact on a shared vertex may belong to the neighboring segment
+        if (t <= 0 && neighborOwnsVertex(shape, i, true, c.center)) {
+            return;
+        }
+        if (t >= glm::dot(d, d) &&
+            neighborOwnsVertex(shape, i, false, c.center)) {
+            return;
+        }
+
+        contact_2d_t seg_contact;
+        if (circleToThickLineSegment(c, seg, seg_contact) == false) {
+            return;
+        }
+        normal_sum += seg_contact.normal * seg_contact.penetration;
+        if (seg_contact.penetration > deepest) {
+            deepest = seg_contact.penetration;
+            contact = seg_contact;
+        }
+    });
+    if (deepest < 0) {
+        return false;
+    }
+
+    // blend the normals of all the touching segments, weighted by their
+    // penetration, so a circle in a crease is pushed out of both faces
+    if (glm::dot(normal_sum, normal_sum) > EPSILON * EPSILON) {
+        contact.normal = glm::normalize(normal_sum);
+    }
+    return true;
+}
+
+/// @brief Check if a circle overlaps a polyline
+template <typename Shape>
+bool circleOverlapsPolyline(const Shape &shape, const circle_2d_t &c) {
+    const glm::vec2 extent = {c.radius, c.radius};
+    bool            hit = false;
+    shape.query({c.center - extent, c.center + extent}, [&](uint32_t i) {
+        hit = hit || circleOverlapsThickLineSegment(c, shape.segment(i));
+    });
+    return hit;
+}
+
+/// @brief First time of impact of a moving circle with a polyline
+/// @param shape the polyline
+/// @param c circle at the start of the motion
+/// @param sweep displacement of the circle
+/// @param toi time of impact in [0, 1] if hit
+/// @return true if the circle hits the polyline
+template <typename Shape>
+bool timeOfImpactCircleToPolyline(const Shape &shape, const circle_2d_t &c,
+                                  const glm::vec2 &sweep, float &toi) {
+    const glm::vec2 extent = {c.radius, c.radius};
+    const glm::vec2 end = c.center + sweep;
+    const aabb_2d_t aabb = {glm::min(c.center, end) - extent,
+                            glm::max(c.center, end) + extent};
+    bool            hit = false;
+    toi = 1.0f;
+    shape.query(aabb, [&](uint32_t i) {
+        float seg_toi = 1.0f;
+        if (timeOfImpactCircleToThickLineSegment(c, sweep, shape.segment(i),
+                                                 seg_toi) &&
+            (hit == false || seg_toi < toi)) {
+            toi = seg_toi;
+            hit = true;
+        }
+    });
+    return hit;
+}
+
+/// @brief Collide an oriented box with a polyline
+/// @param shape the polyline
+/// @param b box
+/// @param contact the deepest contact if collision.  The normal points
+/// from the box to the polyline.
+/// @return true if collision
+template <typename Shape>
+bool boxToPolyline(const Shape &shape, const box_2d_t &b,
+                   contact_2d_t &contact) {
+    float deepest = -1.0f;
+    shape.query(boxAabb(b), [&](uint32_t i) {
+        contact_2d_t seg_contact;
+        if (thickLineSegmentToBox(shape.segment(i), b, seg_contact) &&
+            seg_contact.penetration > deepest) {
+            deepest = seg_contact.penetration;
+            contact = seg_contact;
+        }
+    });
+    if (deepest < 0) {
+        return false;
+    }
+    contact.normal = -contact.normal; // from the box to the polyline
+    return true;
+}
+
+} // namespace zo
+#endif // __zoPhysicsPolyline_h__
@@ -37,6 +37,18 @@ struct CollisionPair {
     ColliderHandle b;
     contact_2d_t   contact;
 
+    /// @brief Fraction of the step at which a swept collider (see:
+    /// Collider2dImpl::Data::sweep) first made contact.  1 is the end of
+    /// the step.
+    float toi = 1.0f;
+
+    /// @brief Key of the pair independent of the order of the colliders
+    uint64_t key() const {
+        const uint32_t lo = a.handle < b.handle ? a.handle : b.handle;
+        const uint32_t hi = a.handle < b.handle ? b.handle : a.handle;
+        return (uint64_t(lo) << 32) | hi;
+    }
+
     bool operator==(const CollisionPair &rhs) const {
         return a.handle == rhs.a.handle && b.handle == rhs.b.handle;
     }
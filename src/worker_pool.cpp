@@ -0,0 +1,81 @@
+/**
+ * @file worker_pool.cpp
+ * @author Micah Pearlman (micahpearlman@gmail.com)
+ * @brief
+ * @version 0.1
+ * @date 2024-10-14
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#include "worker_pool.hpp"
+
+namespace zo {
+
+WorkerPool::WorkerPool(size_t num_threads) {
+    for (size_t i = 1; i < num_threads; i++) {
+        _threads.emplace_back([this, i] { workerLoop(i); });
+    }
+}
+
+WorkerPool::~WorkerPool() {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stop = true;
+    }
+    _start_cv.notify_all();
+    for (std::thread &thread : _threads) {
+        thread.join();
+    }
+}
+
+void WorkerPool::run(const std::function<void(size_t)> &task) {
+    if (_threads.empty()) {
+        task(0);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _task = &task;
+        _pending = _threads.size();
+        _generation++;
+    }
+    _start_cv.notify_all();
+
+    // the calling thread is worker 0
+    task(0);
+
+    std::unique_lock<std::mutex> lock(_mutex);
+    _done_cv.wait(lock, [this] { return _pending == 0; });
+    _task = nullptr;
+}
+
+void WorkerPool::workerLoop(size_t worker) {
+    uint64_t generation = 0;
+    while (true) {
+        const std::function<void(size_t)> *task = nullptr;
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _start_cv.wait(lock, [&] {
+                return _stop || _generation != generation;
+            });
+            if (_stop) {
+                return;
+            }
+            generation = _generation;
+            task = _task;
+        }
+
+        (*task)(worker);
+
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (--_pending == 0) {
+                _done_cv.notify_one();
+            }
+        }
+    }
+}
+
+} // namespace zo
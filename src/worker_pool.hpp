@@ -0,0 +1,79 @@
+/**
+ * @file worker_pool.hpp
+ * @author Micah Pearlman (micahpearlman@gmail.com)
+ * @brief A minimal pool of persistent worker threads.
+ * @version 0.1
+ * @date 2024-10-14
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#ifndef __zoWorkerPool_h__
+#define __zoWorkerPool_h__
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace zo {
+
+/// @brief A pool of persistent worker threads.  The calling thread always
+/// takes part as worker 0 so a pool of 1 thread runs everything inline.
+class WorkerPool {
+  public:
+    /// @brief Construct a worker pool
+    /// @param num_threads total number of threads including the caller
+    explicit WorkerPool(size_t num_threads = 1);
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool &) = delete;
+    WorkerPool &operator=(const WorkerPool &) = delete;
+
+    /// @brief Total number of threads including the caller
+    size_t numThreads() const { return _threads.size() + 1; }
+
+    /// @brief Run task(worker_index) once on every thread and wait for all
+    /// of them to finish.
+    /// @param task the task to run
+    void run(const std::function<void(size_t)> &task);
+
+    /// @brief Split [0, count) into contiguous ranges, one per thread in
+    /// worker order, and call fn(begin, end, worker_index) for each non empty
+    /// range.  Waits for all ranges to finish.
+    /// @param count the number of items
+    /// @param fn the function to call for each range
+    template <typename Fn> void parallelFor(size_t count, Fn &&fn) {
+        const size_t num_threads = numThreads();
+        if (num_threads == 1 || count < 2) {
+            if (count > 0) {
+                fn(size_t(0), count, size_t(0));
+            }
+            return;
+        }
+        run([&](size_t worker) {
+            const size_t begin = count * worker / num_threads;
+            const size_t end = count * (worker + 1) / num_threads;
+            if (begin < end) {
+                fn(begin, end, worker);
+            }
+        });
+    }
+
+  private:
+    void workerLoop(size_t worker);
+
+  private:
+    std::vector<std::thread>          _threads;
+    std::mutex                        _mutex;
+    std::condition_variable           _start_cv;
+    std::condition_variable           _done_cv;
+    const std::function<void(size_t)> *_task = nullptr;
+    uint64_t                          _generation = 0;
+    size_t                            _pending = 0;
+    bool                              _stop = false;
+};
+
+} // namespace zo
+#endif // __zoWorkerPool_h__
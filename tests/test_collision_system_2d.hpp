@@ -7,6 +7,7 @@
 #include <zero_physics/collision_system_2d.hpp>
 #include <zero_physics/collider_2d.hpp>
 #include <zero_physics/types.hpp>
+#include "collision_system_2d_impl.hpp"
 
 using namespace zo;
 
@@ -46,3 +47,42 @@ TEST_F(CollisionSystem2dTest, CreateColliderToExhaustion) {
 
 } // namespace zo
 
+TEST_F(CollisionSystem2dTest, OverlappingCollidersArePaired) {
+    // colliders without a physics system are not static, so they are paired
+    // with each other
+    auto a = collisionSystem->createCollider<CircleCollider2d>();
+    a->setCircle({{0.0f, 0.0f}, 1.0f});
+    auto b = collisionSystem->createCollider<CircleCollider2d>();
+    b->setCircle({{1.5f, 0.0f}, 1.0f});
+    const auto &impl = static_cast<CollisionSystem2dImpl &>(*collisionSystem);
+
+    collisionSystem->generateCollisionPairs();
+    CollisionPair expected;
+    expected.a = a->handle();
+    expected.b = b->handle();
+    ASSERT_EQ(impl.collisionPairs().size(), 1u);
+    EXPECT_EQ(impl.collisionPairs()[0].key(), expected.key());
+
+    b->setCenter({3.0f, 0.0f});
+    collisionSystem->generateCollisionPairs();
+    EXPECT_TRUE(impl.collisionPairs().empty());
+}
+
+TEST_F(CollisionSystem2dTest, SensorOverlapsMovedCollider) {
+    auto zone = collisionSystem->createCollider<CircleCollider2d>();
+    zone->setCircle({{0.0f, 0.0f}, 3.0f});
+    zone->setSensor(true);
+    auto line = collisionSystem->createCollider<LineCollider2d>();
+    line->setLine({{{10.0f, -5.0f}, {10.0f, 5.0f}}, 0.5f});
+
+    collisionSystem->generateCollisionPairs();
+    EXPECT_EQ(collisionSystem->numSensorOverlaps(), 0u);
+    EXPECT_FALSE(collisionSystem->sensorOverlaps(*zone, *line));
+
+    // moved by hand into the zone
+    line->setLine({{{2.0f, -5.0f}, {2.0f, 5.0f}}, 0.5f});
+    collisionSystem->generateCollisionPairs();
+    EXPECT_EQ(collisionSystem->numSensorOverlaps(), 1u);
+    EXPECT_TRUE(collisionSystem->sensorOverlaps(*zone, *line));
+    EXPECT_TRUE(collisionSystem->sensorOverlaps(*line, *zone));
+}
@@ -3,6 +3,8 @@
 #include "test_memory.hpp"
 #include "test_collision_system_2d.hpp"
 #include "test_math.hpp"
+#include "test_narrow_phase.hpp"
+#include "test_physics_system_2d.hpp"
 int main(int argc, char **argv) {
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
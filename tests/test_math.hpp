@@ -83,4 +83,155 @@ TEST(MathTest, CircleToThickLineSegment) {
     ASSERT_FALSE(result);
 
 
-}
\ No newline at end of file
+}
+
+TEST(MathTest, CircleOverlaps) {
+    circle_2d_t c{glm::vec2(0.0f, 0.0f), 5.0f};
+    EXPECT_TRUE(circleOverlapsCircle(c, {glm::vec2(7.0f, 0.0f), 5.0f}));
+    EXPECT_TRUE(circleOverlapsCircle(c, {glm::vec2(10.0f, 0.0f), 5.0f}));
+    EXPECT_FALSE(circleOverlapsCircle(c, {glm::vec2(11.0f, 0.0f), 5.0f}));
+
+    thick_line_segment_2d_t ls{
+        line_segment_2d_t{glm::vec2(7.0f, -5.0f), glm::vec2(7.0f, 5.0f)}, 1.0f};
+    EXPECT_FALSE(circleOverlapsThickLineSegment(c, ls));
+    ls.radius = 2.5f;
+    EXPECT_TRUE(circleOverlapsThickLineSegment(c, ls));
+}
+
+TEST(MathTest, TimeOfImpact) {
+    // circle moving 20 to the right hits a circle at x = 10 after 5 units
+    circle_2d_t c{glm::vec2(0.0f, 0.0f), 1.0f};
+    float       toi = -1.0f;
+    ASSERT_TRUE(timeOfImpactCircleToCircle(c, {20.0f, 0.0f},
+                                           {glm::vec2(10.0f, 0.0f), 4.0f},
+                                           {0.0f, 0.0f}, toi));
+    EXPECT_NEAR(toi, 0.25f, 1e-5);
+    EXPECT_FALSE(timeOfImpactCircleToCircle(c, {-20.0f, 0.0f},
+                                            {glm::vec2(10.0f, 0.0f), 4.0f},
+                                            {0.0f, 0.0f}, toi));
+
+    // both moving towards each other
+    ASSERT_TRUE(timeOfImpactCircleToCircle(c, {10.0f, 0.0f},
+                                           {glm::vec2(10.0f, 0.0f), 1.0f},
+                                           {-10.0f, 0.0f}, toi));
+    EXPECT_NEAR(toi, 0.4f, 1e-5);
+
+    // thin wall at x = 10 crossed in one step
+    thick_line_segment_2d_t wall{
+        line_segment_2d_t{glm::vec2(10.0f, -5.0f), glm::vec2(10.0f, 5.0f)},
+        0.5f};
+    ASSERT_TRUE(
+        timeOfImpactCircleToThickLineSegment(c, {40.0f, 0.0f}, wall, toi));
+    EXPECT_NEAR(toi, 8.5f / 40.0f, 1e-5);
+
+    // passing the end cap
+    ASSERT_TRUE(timeOfImpactCircleToThickLineSegment(
+        {glm::vec2(0.0f, 6.0f), 1.0f}, {40.0f, 0.0f}, wall, toi));
+    EXPECT_GT(toi, 8.5f / 40.0f);
+    EXPECT_FALSE(timeOfImpactCircleToThickLineSegment(
+        {glm::vec2(0.0f, 7.0f), 1.0f}, {40.0f, 0.0f}, wall, toi));
+
+    // already overlapping
+    ASSERT_TRUE(timeOfImpactCircleToThickLineSegment(
+        {glm::vec2(10.0f, 0.0f), 1.0f}, {40.0f, 0.0f}, wall, toi));
+    EXPECT_EQ(toi, 0.0f);
+}
+
+TEST(MathTest, ThickLineSegmentToThickLineSegment) {
+    thick_line_segment_2d_t ls1{
+        line_segment_2d_t{glm::vec2(0.0f, 0.0f), glm::vec2(10.0f, 0.0f)}, 1.0f};
+    thick_line_segment_2d_t ls2{
+        line_segment_2d_t{glm::vec2(5.0f, 1.5f), glm::vec2(5.0f, 10.0f)}, 1.0f};
+
+    contact_2d_t contact;
+    ASSERT_TRUE(thickLineSegmentToThickLineSegment(ls1, ls2, contact));
+    EXPECT_NEAR(contact.normal.x, 0.0f, 1e-5);
+    EXPECT_NEAR(contact.normal.y, 1.0f, 1e-5);
+    EXPECT_NEAR(contact.penetration, 0.5f, 1e-5);
+    EXPECT_TRUE(thickLineSegmentOverlapsThickLineSegment(ls1, ls2));
+
+    // crossing: ls2's shallow end is 1 below ls1 so ls2 is pushed up, i.e.
+    // the normal from ls2 to ls1 points down
+    ls2.line.start = glm::vec2(5.0f, -1.0f);
+    ASSERT_TRUE(thickLineSegmentToThickLineSegment(ls2, ls1, contact));
+    EXPECT_NEAR(contact.normal.y, -1.0f, 1e-5);
+    EXPECT_NEAR(contact.penetration, 3.0f, 1e-5);
+
+    ls2.line.start = glm::vec2(5.0f, 3.0f);
+    EXPECT_FALSE(thickLineSegmentToThickLineSegment(ls1, ls2, contact));
+    EXPECT_FALSE(thickLineSegmentOverlapsThickLineSegment(ls1, ls2));
+}
+
+TEST(MathTest, BoxAabb) {
+    box_2d_t  box{glm::vec2(1.0f, 2.0f), glm::vec2(2.0f, 1.0f), 0.0f};
+    aabb_2d_t aabb = boxAabb(box);
+    EXPECT_EQ(aabb.mn, glm::vec2(-1.0f, 1.0f));
+    EXPECT_EQ(aabb.mx, glm::vec2(3.0f, 3.0f));
+
+    box.angle = glm::radians(90.0f);
+    aabb = boxAabb(box);
+    EXPECT_NEAR(aabb.mn.x, 0.0f, 1e-5);
+    EXPECT_NEAR(aabb.mn.y, 0.0f, 1e-5);
+    EXPECT_NEAR(aabb.mx.x, 2.0f, 1e-5);
+    EXPECT_NEAR(aabb.mx.y, 4.0f, 1e-5);
+}
+
+TEST(MathTest, CircleToBox) {
+    box_2d_t     box{glm::vec2(0.0f, 0.0f), glm::vec2(2.0f, 1.0f), 0.0f};
+    contact_2d_t contact;
+
+    // above the top face
+    ASSERT_TRUE(circleToBox({glm::vec2(0.5f, 1.5f), 1.0f}, box, contact));
+    EXPECT_NEAR(contact.normal.x, 0.0f, 1e-5);
+    EXPECT_NEAR(contact.normal.y, -1.0f, 1e-5);
+    EXPECT_NEAR(contact.penetration, 0.5f, 1e-5);
+    EXPECT_EQ(contact.point, glm::vec2(0.5f, 1.0f));
+
+    // center inside the box, pushed out through the nearest (right) face
+    ASSERT_TRUE(circleToBox({glm::vec2(1.8f, 0.0f), 0.5f}, box, contact));
+    EXPECT_NEAR(contact.normal.x, -1.0f, 1e-5);
+    EXPECT_NEAR(contact.penetration, 0.7f, 1e-5);
+
+    // near the corner of a rotated box
+    box.angle = glm::radians(45.0f);
+    EXPECT_FALSE(circleToBox({glm::vec2(2.5f, 0.0f), 0.5f}, box, contact));
+    EXPECT_TRUE(circleToBox({glm::vec2(2.0f, 0.0f), 0.5f}, box, contact));
+}
+
+TEST(MathTest, BoxToBox) {
+    box_2d_t     b1{glm::vec2(0.0f, 0.0f), glm::vec2(1.0f, 1.0f), 0.0f};
+    box_2d_t     b2{glm::vec2(1.5f, 0.5f), glm::vec2(1.0f, 1.0f), 0.0f};
+    contact_2d_t contact;
+
+    ASSERT_TRUE(boxToBox(b1, b2, contact));
+    EXPECT_NEAR(contact.normal.x, 1.0f, 1e-5);
+    EXPECT_NEAR(contact.normal.y, 0.0f, 1e-5);
+    EXPECT_NEAR(contact.penetration, 0.5f, 1e-5);
+    EXPECT_NEAR(contact.point.x, 0.5f, 1e-5);
+
+    // a diamond whose corner pokes into b1
+    b2 = {glm::vec2(2.2f, 0.0f), glm::vec2(1.0f, 1.0f), glm::radians(45.0f)};
+    ASSERT_TRUE(boxToBox(b1, b2, contact));
+    EXPECT_NEAR(contact.penetration, std::sqrt(2.0f) - 1.2f, 1e-4);
+    EXPECT_NEAR(contact.point.x, 2.2f - std::sqrt(2.0f), 1e-4);
+    EXPECT_NEAR(contact.point.y, 0.0f, 1e-4);
+
+    // separated along the diamond's axis only
+    b2.center = glm::vec2(2.0f, 2.0f);
+    EXPECT_FALSE(boxToBox(b1, b2, contact));
+}
+
+TEST(MathTest, ThickLineSegmentToBox) {
+    thick_line_segment_2d_t floor{
+        line_segment_2d_t{glm::vec2(-10.0f, 0.0f), glm::vec2(10.0f, 0.0f)},
+        0.5f};
+    box_2d_t     box{glm::vec2(0.0f, -1.25f), glm::vec2(1.0f, 1.0f), 0.0f};
+    contact_2d_t contact;
+
+    ASSERT_TRUE(thickLineSegmentToBox(floor, box, contact));
+    EXPECT_NEAR(contact.normal.y, -1.0f, 1e-5);
+    EXPECT_NEAR(contact.penetration, 0.25f, 1e-5);
+
+    box.center.y = -1.75f;
+    EXPECT_FALSE(thickLineSegmentToBox(floor, box, contact));
+}
@@ -0,0 +1,78 @@
+/**
+ * @file test_narrow_phase.hpp
+ * @brief Unit tests for the batched narrow phase kernels
+ */
+
+#include <gtest/gtest.h>
+#include <zero_physics/math.hpp>
+#include <zero_physics/types.hpp>
+#include "narrow_phase.hpp"
+#include <random>
+#include <utility>
+#include <vector>
+
+using namespace zo;
+
+/// @brief Random circle pairs cycling through misses, overlaps and pairs
+/// touching exactly
+static std::vector<std::pair<circle_2d_t, circle_2d_t>>
+randomCirclePairs(size_t num_pairs, uint32_t seed) {
+    std::mt19937                          rng(seed);
+    std::uniform_real_distribution<float> position(-50.0f, 50.0f);
+    std::uniform_int_distribution<int>    radius(1, 4);
+    std::vector<std::pair<circle_2d_t, circle_2d_t>> pairs;
+    for (size_t i = 0; i < num_pairs; i++) {
+        circle_2d_t c1 = {{position(rng), position(rng)}, float(radius(rng))};
+        circle_2d_t c2 = {c1.center, float(radius(rng))};
+        const float radius_sum = c1.radius + c2.radius;
+        switch (i % 3) {
+        case 0: // miss
+            c2.center += glm::vec2(radius_sum + 1.0f, -radius_sum);
+            break;
+        case 1: // overlap
+            c2.center += glm::vec2(0.5f * radius_sum, 0.25f * radius_sum);
+            break;
+        default: // touch, exactly representable
+            c1.center = glm::floor(c1.center);
+            c2.center = c1.center + glm::vec2(0.0f, radius_sum);
+            break;
+        }
+        pairs.push_back({c1, c2});
+    }
+    return pairs;
+}
+
+TEST(NarrowPhaseTest, CircleCircleBatchMatchesCircleToCircle) {
+    // one batch reused for every size, so shrinking leaves stale data in
+    // the tail lanes
+    CircleCircleBatch batch;
+    for (size_t num_pairs : {21, 1, 5, 8, 13, 3, 16, 0, 7}) {
+        const auto pairs = randomCirclePairs(num_pairs, uint32_t(num_pairs));
+        batch.clear();
+        for (const auto &[c1, c2] : pairs) {
+            batch.add(c1, c2);
+        }
+        ASSERT_EQ(batch.size(), num_pairs);
+        batch.collide();
+
+        for (size_t i = 0; i < num_pairs; i++) {
+            contact_2d_t expected;
+            const bool   hit =
+                circleToCircle(pairs[i].first, pairs[i].second, expected);
+            ASSERT_EQ(batch.hit(i), hit) << num_pairs << " pairs, pair " << i;
+            EXPECT_EQ(hit, i % 3 != 0);
+            if (hit == false) {
+                continue;
+            }
+            const contact_2d_t contact = batch.contact(i);
+            EXPECT_NEAR(contact.normal.x, expected.normal.x, 1e-5f);
+            EXPECT_NEAR(contact.normal.y, expected.normal.y, 1e-5f);
+            EXPECT_NEAR(contact.point.x, expected.point.x, 1e-4f);
+            EXPECT_NEAR(contact.point.y, expected.point.y, 1e-4f);
+            EXPECT_NEAR(contact.penetration, expected.penetration, 1e-4f);
+            if (i % 3 == 2) {
+                EXPECT_EQ(contact.penetration, 0.0f);
+            }
+        }
+    }
+}
@@ -0,0 +1,982 @@
+/**
+ * @file test_physics_system_2d.hpp
+ * @brief Unit tests for zo::PhysicsSystem2d
+ */
+
+#include <gtest/gtest.h>
+#include <zero_physics/physics_system_2d.hpp>
+#include <zero_physics/collider_2d.hpp>
+#include <zero_physics/types.hpp>
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <optional>
+#include <random>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+using namespace zo;
+
+/// @brief Attach a collider to a static physics object.  This keeps it out of
+/// the broad phase, colliders without a physics object are dynamic.
+static std::unique_ptr<PhysicsObject2d>
+attachToStaticObject(PhysicsSystem2d &physics_system, Collider2d &collider) {
+    auto object = physics_system.createPhysicsObject();
+    object->setStatic(true);
+    object->setCollider(collider, 0);
+    return object;
+}
+
+/// @brief Drop a row of balls from @p start_y onto a ground collider, which
+/// is attached to a static object, and return the ball positions after the
+/// simulation.
+static std::vector<glm::vec2> dropBallsOnGround(PhysicsSystem2d &physics_system,
+                                                Collider2d      &ground,
+                                                float start_y = 0.0f) {
+    physics_system.setGravity({0, 100.0f});
+    auto ground_object = attachToStaticObject(physics_system, ground);
+
+    std::vector<std::unique_ptr<PhysicsObject2d>>  balls;
+    std::vector<std::unique_ptr<CircleCollider2d>> colliders;
+    for (int i = 0; i < 8; i++) {
+        auto ball = physics_system.createPhysicsObject();
+        ball->setPosition({-40.0f + i * 10.0f, start_y});
+        auto collider = physics_system.collisionSystem()
+                            .createCollider<CircleCollider2d>();
+        collider->setRadius(1.0f);
+        ball->setCollider(*collider, 0);
+        balls.push_back(std::move(ball));
+        colliders.push_back(std::move(collider));
+    }
+
+    for (int frame = 0; frame < 250; frame++) {
+        physics_system.update(0.01f);
+    }
+    std::vector<glm::vec2> positions;
+    for (const auto &ball : balls) {
+        positions.push_back(ball->position());
+    }
+    return positions;
+}
+
+/// @brief Drop a row of balls onto a floor line and return the largest ball
+/// center y (i.e., the deepest ball, y points down) after the simulation.
+static float dropBallsOnFloor(BroadPhaseType broad_phase_type,
+                              size_t         num_threads = 1,
+                              const broad_phase_config_t &config = {},
+                              broad_phase_stats_t        *stats = nullptr) {
+    auto physics_system =
+        PhysicsSystem2d::create(64, 1, broad_phase_type, config, num_threads);
+
+    // floor at y = 10
+    auto floor = physics_system->collisionSystem()
+                     .createCollider<LineCollider2d>();
+    floor->setLine({{{-100.0f, 10.0f}, {100.0f, 10.0f}}, 1.0f});
+
+    float deepest = -std::numeric_limits<float>::max();
+    for (const glm::vec2 &p : dropBallsOnGround(*physics_system, *floor)) {
+        deepest = std::max(deepest, p.y);
+    }
+    if (stats != nullptr) {
+        *stats = physics_system->collisionSystem().broadPhaseStats();
+    }
+    return deepest;
+}
+
+TEST(PhysicsSystem2dTest, NaiveBroadPhaseStopsBalls) {
+    EXPECT_LT(dropBallsOnFloor(BroadPhaseType::NAIVE), 10.0f);
+}
+
+/// @brief Move a random scene of overlapping sensor balls of mixed sizes
+/// for a few frames and return the overlapping ball index pairs of every
+/// frame.  Sensors are never resolved so the overlaps are exactly the pairs
+/// the broad phase found that overlap.
+static std::vector<std::vector<std::pair<int, int>>>
+sensorOverlapsOfRandomScene(
+    BroadPhaseType broad_phase_type, size_t num_threads, unsigned seed,
+    const broad_phase_config_t &config = {.grid_size = 8.0f}) {
+    constexpr int num_balls = 200;
+    auto          physics_system = PhysicsSystem2d::create(
+        num_balls, 1, broad_phase_type, config, num_threads);
+    physics_system->setGravity({0, 0});
+    CollisionSystem2d &collision_system = physics_system->collisionSystem();
+
+    std::mt19937                          rng(seed);
+    std::uniform_real_distribution<float> position(0.0f, 100.0f);
+    std::uniform_real_distribution<float> radius(0.5f, 3.0f);
+    std::uniform_real_distribution<float> velocity(-200.0f, 200.0f);
+    std::vector<std::unique_ptr<PhysicsObject2d>>  balls;
+    std::vector<std::unique_ptr<CircleCollider2d>> colliders;
+    for (int i = 0; i < num_balls; i++) {
+        auto ball = physics_system->createPhysicsObject();
+        ball->setPosition({position(rng), position(rng)});
+        ball->setVelocity({velocity(rng), velocity(rng)});
+        auto collider = collision_system.createCollider<CircleCollider2d>();
+        // every 16th ball is large so the sizes are mixed
+        collider->setRadius(i % 16 == 0 ? 12.0f * radius(rng) : radius(rng));
+        collider->setSensor(true);
+        ball->setCollider(*collider, 0);
+        balls.push_back(std::move(ball));
+        colliders.push_back(std::move(collider));
+    }
+
+    std::vector<std::vector<std::pair<int, int>>> frames;
+    for (int frame = 0; frame < 4; frame++) {
+        physics_system->update(0.01f);
+        std::vector<std::pair<int, int>> &overlaps = frames.emplace_back();
+        for (int i = 0; i < num_balls; i++) {
+            for (int j = i + 1; j < num_balls; j++) {
+                if (collision_system.sensorOverlaps(*colliders[i],
+                                                    *colliders[j])) {
+                    overlaps.emplace_back(i, j);
+                }
+            }
+        }
+    }
+    return frames;
+}
+
+TEST(PhysicsSystem2dTest, BroadPhasesMatchNaive) {
+    for (unsigned seed : {1u, 2u, 3u}) {
+        const auto expected =
+            sensorOverlapsOfRandomScene(BroadPhaseType::NAIVE, 1, seed);
+        ASSERT_GT(expected.front().size(), 100u);
+        for (BroadPhaseType type :
+             {BroadPhaseType::GRID, BroadPhaseType::SWEEP_PRUNE,
+              BroadPhaseType::DYNAMIC_TREE, BroadPhaseType::VERLET_LIST,
+              BroadPhaseType::BRUTE_FORCE, BroadPhaseType::HIERARCHICAL_GRID,
+              BroadPhaseType::LINEAR_BVH, BroadPhaseType::SPATIAL_HASH,
+              BroadPhaseType::AUTO}) {
+            for (size_t num_threads : {1, 4}) {
+                // EXPECT_TRUE so a mismatch doesn't print thousands of pairs
+                EXPECT_TRUE(sensorOverlapsOfRandomScene(type, num_threads,
+                                                        seed) == expected)
+                    << "broad phase " << int(type) << ", " << num_threads
+                    << " threads, seed " << seed;
+            }
+        }
+    }
+}
+
+TEST(PhysicsSystem2dTest, MultiThreadedGridBroadPhaseMatchesSingleThreaded) {
+    // the scene spans over a dozen rows of 8 unit cells so the rows are
+    // split into stripes, unevenly with 3 threads
+    for (unsigned seed : {1u, 2u}) {
+        const auto expected =
+            sensorOverlapsOfRandomScene(BroadPhaseType::GRID, 1, seed);
+        for (size_t num_threads : {2, 3, 4}) {
+            EXPECT_TRUE(sensorOverlapsOfRandomScene(BroadPhaseType::GRID,
+                                                    num_threads,
+                                                    seed) == expected)
+                << num_threads << " threads, seed " << seed;
+        }
+    }
+}
+
+TEST(PhysicsSystem2dTest, GridBroadPhaseClampsToWorldBounds) {
+    const auto expected =
+        sensorOverlapsOfRandomScene(BroadPhaseType::NAIVE, 1, 1);
+
+    // most of the scene is outside the bounds and lands in the border cells
+    const broad_phase_config_t bounded = {
+        .grid_size = 8.0f, .world_bounds = {{40.0f, 40.0f}, {60.0f, 60.0f}}};
+    // far more cells than the per axis limit
+    const broad_phase_config_t tiny_cells = {.grid_size = 1e-9f};
+    for (const broad_phase_config_t &config : {bounded, tiny_cells}) {
+        for (size_t num_threads : {1, 4}) {
+            EXPECT_TRUE(sensorOverlapsOfRandomScene(BroadPhaseType::GRID,
+                                                    num_threads, 1,
+                                                    config) == expected)
+                << "grid size " << config.grid_size << ", " << num_threads
+                << " threads";
+        }
+    }
+
+    for (float grid_size : {0.0f, -1.0f, std::nanf("")}) {
+        EXPECT_THROW(PhysicsSystem2d::create(16, 1, BroadPhaseType::GRID,
+                                             {.grid_size = grid_size}),
+                     std::runtime_error);
+    }
+}
+
+/// @brief Roll ball a into ball b past colliders with NaN, inverted
+/// (negative radius) or infinite bounds and return true if they collided.
+static bool rollBallPastInvalidBounds(BroadPhaseType broad_phase_type) {
+    auto physics_system = PhysicsSystem2d::create(16, 1, broad_phase_type);
+    physics_system->setGravity({0, 0});
+    std::vector<std::unique_ptr<PhysicsObject2d>>  balls;
+    std::vector<std::unique_ptr<CircleCollider2d>> colliders;
+    const float inf = std::numeric_limits<float>::infinity();
+    const float nan = std::numeric_limits<float>::quiet_NaN();
+    for (const auto &[position, radius] :
+         std::initializer_list<std::pair<glm::vec2, float>>{
+             {{0.0f, 0.0f}, 1.0f},
+             {{10.0f, 0.0f}, 1.0f},
+             {{5.0f, 0.0f}, nan},
+             {{5.0f, 0.0f}, -1.0f},
+             {{inf, 0.0f}, 1.0f}}) {
+        auto ball = physics_system->createPhysicsObject();
+        ball->setPosition(position);
+        auto collider = physics_system->collisionSystem()
+                            .createCollider<CircleCollider2d>();
+        collider->setRadius(radius);
+        ball->setCollider(*collider, 0);
+        balls.push_back(std::move(ball));
+        colliders.push_back(std::move(collider));
+    }
+    balls[0]->setVelocity({50.0f, 0.0f});
+
+    for (int frame = 0; frame < 100; frame++) {
+        physics_system->update(0.01f);
+    }
+    return balls[0]->position().x < balls[1]->position().x;
+}
+
+TEST(PhysicsSystem2dTest, SweepAndPruneSkipsInvalidBounds) {
+    EXPECT_TRUE(rollBallPastInvalidBounds(BroadPhaseType::SWEEP_PRUNE));
+}
+
+TEST(PhysicsSystem2dTest, SpatialHashClampsInvalidBounds) {
+    EXPECT_TRUE(rollBallPastInvalidBounds(BroadPhaseType::SPATIAL_HASH));
+}
+
+TEST(PhysicsSystem2dTest, LinearBvhClampsInvalidBounds) {
+    EXPECT_TRUE(rollBallPastInvalidBounds(BroadPhaseType::LINEAR_BVH));
+}
+
+TEST(PhysicsSystem2dTest, HierarchicalGridClampsInvalidBounds) {
+    EXPECT_TRUE(rollBallPastInvalidBounds(BroadPhaseType::HIERARCHICAL_GRID));
+}
+
+TEST(PhysicsSystem2dTest, AutoBroadPhaseSwitches) {
+    // few colliders stay on the naive broad phase
+    broad_phase_stats_t stats;
+    EXPECT_LT(dropBallsOnFloor(BroadPhaseType::AUTO, 1, {}, &stats), 10.0f);
+    EXPECT_TRUE(stats.is_auto);
+    EXPECT_EQ(stats.type, BroadPhaseType::NAIVE);
+    EXPECT_EQ(stats.num_switches, 0u);
+    EXPECT_EQ(stats.num_colliders, 8u);
+
+    // lowering the naive threshold migrates to the grid
+    broad_phase_config_t config;
+    config.auto_thresholds.sample_interval = 1;
+    config.auto_thresholds.naive_max_colliders = 4;
+    EXPECT_LT(dropBallsOnFloor(BroadPhaseType::AUTO, 1, config, &stats),
+              10.0f);
+    EXPECT_EQ(stats.type, BroadPhaseType::GRID);
+    EXPECT_EQ(stats.num_switches, 1u);
+    EXPECT_EQ(stats.last_switch_frame, 1u);
+    EXPECT_EQ(stats.last_switch_reason, BroadPhaseSwitchReason::COLLIDER_COUNT);
+}
+
+TEST(PhysicsSystem2dTest, SetBroadPhaseTypeKeepsColliders) {
+    // ball a rolls into ball b.  The broad phase is switched before they
+    // meet so they only collide if the colliders moved to the new one.
+    auto physics_system = PhysicsSystem2d::create(16, 1, BroadPhaseType::GRID);
+    physics_system->setGravity({0, 0});
+
+    std::vector<std::unique_ptr<PhysicsObject2d>>  balls;
+    std::vector<std::unique_ptr<CircleCollider2d>> colliders;
+    for (int i = 0; i < 2; i++) {
+        auto ball = physics_system->createPhysicsObject();
+        ball->setPosition({i * 10.0f, 0.0f});
+        auto collider = physics_system->collisionSystem()
+                            .createCollider<CircleCollider2d>();
+        collider->setRadius(1.0f);
+        ball->setCollider(*collider, 0);
+        balls.push_back(std::move(ball));
+        colliders.push_back(std::move(collider));
+    }
+    balls[0]->setVelocity({50.0f, 0.0f});
+
+    for (int frame = 0; frame < 100; frame++) {
+        if (frame == 5) {
+            physics_system->collisionSystem().setBroadPhaseType(
+                BroadPhaseType::DYNAMIC_TREE);
+        }
+        physics_system->update(0.01f);
+    }
+    EXPECT_EQ(physics_system->collisionSystem().broadPhaseStats().type,
+              BroadPhaseType::DYNAMIC_TREE);
+    EXPECT_LT(balls[0]->position().x, balls[1]->position().x);
+}
+
+/// @brief Drop a single ball onto a floor line, letting the caller configure
+/// the colliders, and return the ball's center y after the simulation.
+static float
+dropBallOnFloor(BroadPhaseType                                  broad_phase_type,
+                std::function<void(Collider2d &, Collider2d &)> configure) {
+    auto physics_system = PhysicsSystem2d::create(16, 1, broad_phase_type);
+    physics_system->setGravity({0, 100.0f});
+
+    auto floor = physics_system->collisionSystem()
+                     .createCollider<LineCollider2d>();
+    floor->setLine({{{-100.0f, 10.0f}, {100.0f, 10.0f}}, 1.0f});
+
+    auto ball = physics_system->createPhysicsObject();
+    ball->setPosition({0.0f, 0.0f});
+    auto collider =
+        physics_system->collisionSystem().createCollider<CircleCollider2d>();
+    collider->setRadius(1.0f);
+    ball->setCollider(*collider, 0);
+
+    configure(*floor, *collider);
+
+    for (int frame = 0; frame < 250; frame++) {
+        physics_system->update(0.01f);
+    }
+    return ball->position().y;
+}
+
+TEST(PhysicsSystem2dTest, SensorDoesNotStopBall) {
+    for (BroadPhaseType type : {BroadPhaseType::NAIVE, BroadPhaseType::GRID}) {
+        EXPECT_GT(dropBallOnFloor(type,
+                                  [](Collider2d &floor, Collider2d & /*ball*/) {
+                                      floor.setSensor(true);
+                                  }),
+                  10.0f);
+    }
+}
+
+TEST(PhysicsSystem2dTest, SensorReportsOverlaps) {
+    // a ball falls through a static sensor circle
+    auto physics_system = PhysicsSystem2d::create(16, 1, BroadPhaseType::GRID);
+    physics_system->setGravity({0, 100.0f});
+    CollisionSystem2d &collision_system = physics_system->collisionSystem();
+
+    auto zone = collision_system.createCollider<CircleCollider2d>();
+    zone->setCircle({{0.0f, 20.0f}, 3.0f});
+    zone->setSensor(true);
+
+    auto ball = physics_system->createPhysicsObject();
+    auto ball_collider = collision_system.createCollider<CircleCollider2d>();
+    ball_collider->setRadius(1.0f);
+    ball->setCollider(*ball_collider, 0);
+
+    int  overlap_frames = 0;
+    bool overlapped_after = false;
+    for (int frame = 0; frame < 100; frame++) {
+        physics_system->update(0.01f);
+        const bool overlaps =
+            collision_system.sensorOverlaps(*zone, *ball_collider);
+        EXPECT_EQ(overlaps,
+                  collision_system.sensorOverlaps(*ball_collider, *zone));
+        EXPECT_EQ(collision_system.numSensorOverlaps(), overlaps ? 1u : 0u);
+        if (overlaps) {
+            overlap_frames++;
+            overlapped_after = ball->position().y > 20.0f;
+        }
+    }
+
+    // reported while inside, but never pushed out
+    EXPECT_GT(overlap_frames, 0);
+    EXPECT_TRUE(overlapped_after);
+    EXPECT_GT(ball->position().y, 24.0f);
+}
+
+TEST(PhysicsSystem2dTest, DetachedColliderBecomesStatic) {
+    // static colliders are never paired with the static sensor zone
+    auto physics_system = PhysicsSystem2d::create(16, 1, BroadPhaseType::GRID);
+    physics_system->setGravity({0, 0});
+    CollisionSystem2d &collision_system = physics_system->collisionSystem();
+
+    auto zone = collision_system.createCollider<CircleCollider2d>();
+    zone->setCircle({{0.0f, 0.0f}, 3.0f});
+    zone->setSensor(true);
+    auto zone_object = attachToStaticObject(*physics_system, *zone);
+
+    auto ball = physics_system->createPhysicsObject();
+    auto first = collision_system.createCollider<CircleCollider2d>();
+    first->setCircle({{0.0f, 0.0f}, 1.0f});
+    ball->setCollider(*first, 0);
+    physics_system->update(0.01f);
+    EXPECT_TRUE(collision_system.sensorOverlaps(*first, *zone));
+
+    auto second = collision_system.createCollider<CircleCollider2d>();
+    second->setRadius(1.0f);
+    ball->setCollider(*second, 0);
+    physics_system->update(0.01f);
+    EXPECT_FALSE(collision_system.sensorOverlaps(*first, *zone));
+    EXPECT_TRUE(collision_system.sensorOverlaps(*second, *zone));
+}
+
+TEST(PhysicsSystem2dTest, LineWithOneDynamicEndIsDynamic) {
+    // the end mapped last is static, the line still moves with the other end
+    auto physics_system = PhysicsSystem2d::create(16, 1, BroadPhaseType::GRID);
+    physics_system->setGravity({0, 0});
+    CollisionSystem2d &collision_system = physics_system->collisionSystem();
+
+    auto zone = collision_system.createCollider<CircleCollider2d>();
+    zone->setCircle({{0.0f, 0.0f}, 3.0f});
+    zone->setSensor(true);
+    auto zone_object = attachToStaticObject(*physics_system, *zone);
+
+    auto stick = collision_system.createCollider<LineCollider2d>();
+    stick->setLine({{{-5.0f, 0.0f}, {5.0f, 0.0f}}, 0.5f});
+    auto start = physics_system->createPhysicsObject();
+    start->setPosition({-5.0f, 0.0f});
+    start->setCollider(*stick, 0);
+    auto end = physics_system->createPhysicsObject();
+    end->setPosition({5.0f, 0.0f});
+    end->setCollider(*stick, 1);
+    end->setStatic(true);
+
+    physics_system->update(0.01f);
+    EXPECT_TRUE(collision_system.sensorOverlaps(*stick, *zone));
+
+    start->setStatic(true);
+    physics_system->update(0.01f);
+    EXPECT_FALSE(collision_system.sensorOverlaps(*stick, *zone));
+}
+
+TEST(PhysicsSystem2dTest, FilterMaskSkipsCollision) {
+    for (BroadPhaseType type : {BroadPhaseType::NAIVE, BroadPhaseType::GRID}) {
+        // ball is category 2 but the floor only collides with category 1
+        EXPECT_GT(dropBallOnFloor(type,
+                                  [](Collider2d &floor, Collider2d &ball) {
+                                      floor.setFilter(0x0001, 0x0001);
+                                      ball.setFilter(0x0002, 0xffff);
+                                  }),
+                  10.0f);
+
+        // default filters collide
+        EXPECT_LT(dropBallOnFloor(type, [](Collider2d & /*floor*/,
+                                           Collider2d & /*ball*/) {}),
+                  10.0f);
+    }
+}
+
+/// @brief Fire a small ball at a thin wall, fast enough to cross it in a
+/// single step, and return the ball's x after the simulation.
+static float
+fireBallAtWall(BroadPhaseType broad_phase_type, float swept_aabb_threshold,
+               bool                           is_bullet = false,
+               const contact_solver_config_t &solver_config = {},
+               std::optional<float>           restitution = std::nullopt) {
+    broad_phase_config_t config;
+    config.swept_aabb_threshold = swept_aabb_threshold;
+    auto physics_system =
+        PhysicsSystem2d::create(16, 1, broad_phase_type, config);
+    physics_system->setContactSolverConfig(solver_config);
+
+    // wall at x = 20
+    auto wall =
+        physics_system->collisionSystem().createCollider<LineCollider2d>();
+    wall->setLine({{{20.0f, -100.0f}, {20.0f, 100.0f}}, 0.5f});
+
+    auto ball = physics_system->createPhysicsObject();
+    ball->setPosition({0.0f, 0.0f});
+    auto collider =
+        physics_system->collisionSystem().createCollider<CircleCollider2d>();
+    collider->setRadius(1.0f);
+    ball->setCollider(*collider, 0);
+    ball->setVelocity({3000.0f, 0.0f});
+    ball->setBullet(is_bullet);
+    if (restitution.has_value()) {
+        wall->setRestitution(restitution.value());
+        collider->setRestitution(restitution.value());
+    }
+
+    for (int frame = 0; frame < 10; frame++) {
+        physics_system->update(0.01f);
+    }
+    return ball->position().x;
+}
+
+TEST(PhysicsSystem2dTest, SweptAabbStopsFastBall) {
+    for (BroadPhaseType type : {BroadPhaseType::NAIVE, BroadPhaseType::GRID,
+                                BroadPhaseType::DYNAMIC_TREE}) {
+        EXPECT_LT(fireBallAtWall(type, 1.0f), 20.0f);
+
+        // without swept aabbs the ball tunnels through the wall
+        EXPECT_GT(fireBallAtWall(type, -1.0f), 20.0f);
+    }
+}
+
+TEST(PhysicsSystem2dTest, BulletStopsAtWall) {
+    // swept aabbs are disabled for the world but bullets still use ccd
+    EXPECT_LT(fireBallAtWall(BroadPhaseType::GRID, -1.0f, true), 20.0f);
+}
+
+TEST(PhysicsSystem2dTest, IterativeSolverKeepsTimeOfImpact) {
+    // the ball touches the wall at x = 18.5 and stays there
+    for (int iterations : {1, 2, 8}) {
+        const float x = fireBallAtWall(
+            BroadPhaseType::GRID, 1.0f, true,
+            {.velocity_iterations = iterations, .position_iterations = 2},
+            0.0f);
+        EXPECT_NEAR(x, 18.5f, 0.1f) << iterations << " iterations";
+    }
+}
+
+TEST(PhysicsSystem2dTest, BulletIntoCornerRewindsOnce) {
+    // the ball crosses both walls of the corner in the first step.  It is
+    // moved back once, to the right wall it hits first, then slides up into
+    // the corner.
+    for (int iterations : {1, 8}) {
+        auto physics_system = PhysicsSystem2d::create(16, 1);
+        physics_system->setContactSolverConfig(
+            {.velocity_iterations = iterations});
+
+        auto right = physics_system->collisionSystem()
+                         .createCollider<LineCollider2d>();
+        right->setLine({{{20.0f, -100.0f}, {20.0f, 100.0f}}, 0.5f});
+        auto top = physics_system->collisionSystem()
+                       .createCollider<LineCollider2d>();
+        top->setLine({{{-100.0f, 20.0f}, {100.0f, 20.0f}}, 0.5f});
+
+        auto ball = physics_system->createPhysicsObject();
+        ball->setPosition({0.0f, 0.0f});
+        auto collider = physics_system->collisionSystem()
+                            .createCollider<CircleCollider2d>();
+        collider->setRadius(1.0f);
+        ball->setCollider(*collider, 0);
+        ball->setVelocity({3000.0f, 2000.0f});
+        ball->setBullet(true);
+        for (Collider2d *c : std::initializer_list<Collider2d *>{
+                 right.get(), top.get(), collider.get()}) {
+            c->setRestitution(0.0f);
+        }
+
+        physics_system->update(0.01f);
+        EXPECT_NEAR(ball->position().x, 18.5f, 0.1f) << iterations;
+        EXPECT_LT(ball->position().y, 18.5f) << iterations;
+
+        for (int frame = 0; frame < 10; frame++) {
+            physics_system->update(0.01f);
+        }
+        EXPECT_NEAR(ball->position().x, 18.5f, 0.1f) << iterations;
+        EXPECT_NEAR(ball->position().y, 18.5f, 0.1f) << iterations;
+    }
+}
+
+/// @brief Drop a pile of touching balls into a box and return the final
+/// ball positions.
+static std::vector<glm::vec2>
+dropBallPile(size_t            num_threads,
+             ContactSolverType solver = ContactSolverType::SEQUENTIAL) {
+    auto physics_system = PhysicsSystem2d::create(
+        256, 1, BroadPhaseType::GRID, {.grid_size = 8.0f}, num_threads);
+    physics_system->setGravity({0, 100.0f});
+    physics_system->setContactSolverType(solver);
+
+    std::vector<std::unique_ptr<LineCollider2d>> walls;
+    for (const line_segment_2d_t &line :
+         {line_segment_2d_t{{-20.0f, 40.0f}, {20.0f, 40.0f}},
+          line_segment_2d_t{{-20.0f, -40.0f}, {-20.0f, 40.0f}},
+          line_segment_2d_t{{20.0f, -40.0f}, {20.0f, 40.0f}}}) {
+        walls.push_back(
+            physics_system->collisionSystem().createCollider<LineCollider2d>());
+        walls.back()->setLine({line, 1.0f});
+    }
+
+    std::vector<std::unique_ptr<PhysicsObject2d>>  balls;
+    std::vector<std::unique_ptr<CircleCollider2d>> colliders;
+    for (int i = 0; i < 100; i++) {
+        auto ball = physics_system->createPhysicsObject();
+        ball->setPosition({-15.0f + (i % 10) * 3.0f, -30.0f + (i / 10) * 3.0f});
+        auto collider = physics_system->collisionSystem()
+                            .createCollider<CircleCollider2d>();
+        collider->setRadius(1.6f);
+        ball->setCollider(*collider, 0);
+        balls.push_back(std::move(ball));
+        colliders.push_back(std::move(collider));
+    }
+
+    for (int frame = 0; frame < 200; frame++) {
+        physics_system->update(0.01f);
+    }
+    std::vector<glm::vec2> positions;
+    for (const auto &ball : balls) {
+        positions.push_back(ball->position());
+    }
+    return positions;
+}
+
+TEST(PhysicsSystem2dTest, MultiThreadedNarrowPhaseIsDeterministic) {
+    const std::vector<glm::vec2> positions = dropBallPile(1);
+    EXPECT_EQ(dropBallPile(4), positions);
+    EXPECT_EQ(dropBallPile(3), positions);
+}
+
+TEST(PhysicsSystem2dTest, GraphColoredSolverIsDeterministic) {
+    const std::vector<glm::vec2> positions =
+        dropBallPile(1, ContactSolverType::GRAPH_COLORED);
+    EXPECT_EQ(dropBallPile(4, ContactSolverType::GRAPH_COLORED), positions);
+    EXPECT_EQ(dropBallPile(3, ContactSolverType::GRAPH_COLORED), positions);
+
+    // the pile stays in the box
+    for (const glm::vec2 &p : positions) {
+        EXPECT_GT(p.x, -20.0f);
+        EXPECT_LT(p.x, 20.0f);
+        EXPECT_LT(p.y, 40.0f);
+    }
+}
+
+TEST(PhysicsSystem2dTest, BoxesRestOnFloor) {
+    auto physics_system = PhysicsSystem2d::create(16, 1, BroadPhaseType::GRID);
+    physics_system->setGravity({0, 100.0f});
+
+    // floor at y = 10 with a static box standing on it
+    auto floor =
+        physics_system->collisionSystem().createCollider<LineCollider2d>();
+    floor->setLine({{{-100.0f, 10.0f}, {100.0f, 10.0f}}, 1.0f});
+    auto step =
+        physics_system->collisionSystem().createCollider<BoxCollider2d>();
+    step->setBox({{20.0f, 7.0f}, {2.0f, 2.0f}, 0.0f});
+
+    // a box on the floor, a ball on the step and a box on the box
+    auto box = physics_system->createPhysicsObject();
+    box->setPosition({0.0f, 0.0f});
+    auto box_collider =
+        physics_system->collisionSystem().createCollider<BoxCollider2d>();
+    box_collider->setWidth(4.0f);
+    box_collider->setHeight(2.0f);
+    box->setCollider(*box_collider, 0);
+
+    auto top = physics_system->createPhysicsObject();
+    top->setPosition({0.5f, -6.0f});
+    auto top_collider =
+        physics_system->collisionSystem().createCollider<BoxCollider2d>();
+    top_collider->setWidth(2.0f);
+    top_collider->setHeight(2.0f);
+    top->setCollider(*top_collider, 0);
+
+    auto ball = physics_system->createPhysicsObject();
+    ball->setPosition({20.0f, 0.0f});
+    auto ball_collider =
+        physics_system->collisionSystem().createCollider<CircleCollider2d>();
+    ball_collider->setRadius(1.0f);
+    ball->setCollider(*ball_collider, 0);
+
+    for (int frame = 0; frame < 250; frame++) {
+        physics_system->update(0.01f);
+    }
+    // the floor top is at y = 9, the step top at y = 5 (y points down)
+    EXPECT_LT(box->position().y, 9.0f);
+    EXPECT_LT(top->position().y, box->position().y - 1.0f);
+    EXPECT_LT(ball->position().y, 5.0f);
+}
+
+/// @brief Slide a ball along a flat floor at y = 10, made of one line or of
+/// a chain of short segments, and return the final ball position.
+static glm::vec2 slideBallAlongFloor(bool use_chain) {
+    auto physics_system = PhysicsSystem2d::create(16, 1, BroadPhaseType::GRID);
+    physics_system->setGravity({0, 100.0f});
+
+    std::unique_ptr<LineCollider2d>  line;
+    std::unique_ptr<ChainCollider2d> chain;
+    if (use_chain) {
+        std::vector<glm::vec2> vertices;
+        for (int i = 0; i <= 400; i++) {
+            vertices.push_back({-100.0f + i * 0.5f, 10.0f});
+        }
+        chain =
+            physics_system->collisionSystem().createCollider<ChainCollider2d>();
+        chain->setVertices(vertices);
+        chain->setThickness(0.5f);
+    } else {
+        line = physics_system->collisionSystem().createCollider<LineCollider2d>();
+        line->setLine({{{-100.0f, 10.0f}, {100.0f, 10.0f}}, 0.5f});
+    }
+
+    auto ball = physics_system->createPhysicsObject();
+    ball->setPosition({-80.0f, 8.5f});
+    auto collider =
+        physics_system->collisionSystem().createCollider<CircleCollider2d>();
+    collider->setRadius(1.0f);
+    ball->setCollider(*collider, 0);
+    ball->setVelocity({0.5f, 0.0f});
+
+    for (int frame = 0; frame < 250; frame++) {
+        physics_system->update(0.01f);
+    }
+    return ball->position();
+}
+
+TEST(PhysicsSystem2dTest, BallSlidesOverChainVertices) {
+    // the internal chain vertices must not catch the ball, i.e., it slides
+    // like it does on a single line
+    const glm::vec2 on_line = slideBallAlongFloor(false);
+    const glm::vec2 on_chain = slideBallAlongFloor(true);
+    EXPECT_NEAR(on_chain.x, on_line.x, 0.01f);
+    EXPECT_NEAR(on_chain.y, on_line.y, 0.01f);
+    EXPECT_GT(on_chain.x, -79.0f);
+}
+
+TEST(PhysicsSystem2dTest, ChainStopsBalls) {
+    auto physics_system =
+        PhysicsSystem2d::create(64, 1, BroadPhaseType::DYNAMIC_TREE);
+
+    // a closed valley of 1000 segments
+    std::vector<glm::vec2> vertices;
+    for (int i = 0; i < 1000; i++) {
+        const float x = -50.0f + i * 0.1f;
+        vertices.push_back({x, 10.0f - 0.002f * x * x});
+    }
+    vertices.push_back({50.0f, 20.0f});
+    vertices.push_back({-50.0f, 20.0f});
+    auto chain =
+        physics_system->collisionSystem().createCollider<ChainCollider2d>();
+    chain->setVertices(vertices);
+    chain->setLoop(true);
+    chain->setThickness(0.5f);
+    EXPECT_TRUE(chain->isLoop());
+    EXPECT_EQ(chain->vertices().size(), 1002);
+
+    // start above the valley rim
+    for (const glm::vec2 &p :
+         dropBallsOnGround(*physics_system, *chain, -10.0f)) {
+        EXPECT_LT(p.y, 10.0f - 0.002f * p.x * p.x);
+    }
+}
+
+/// @brief Drop balls on rolling terrain, made of a heightfield or of a chain
+/// with the same vertices, and return the final ball positions.
+static std::vector<glm::vec2> dropBallsOnTerrain(bool use_heightfield) {
+    auto physics_system = PhysicsSystem2d::create(64, 1, BroadPhaseType::GRID);
+
+    // 10000 columns, 0.05 apart, around y = 10
+    std::vector<float>     heights;
+    std::vector<glm::vec2> vertices;
+    for (int i = 0; i <= 10000; i++) {
+        const float x = -250.0f + i * 0.05f;
+        heights.push_back(2.0f * std::sin(x * 0.1f));
+        vertices.push_back({x, 10.0f + heights.back()});
+    }
+    std::unique_ptr<Collider2d> terrain;
+    if (use_heightfield) {
+        auto heightfield = physics_system->collisionSystem()
+                               .createCollider<HeightfieldCollider2d>();
+        heightfield->setOrigin({-250.0f, 10.0f});
+        heightfield->setSpacing(0.05f);
+        heightfield->setHeights(heights);
+        heightfield->setThickness(0.5f);
+        terrain = std::move(heightfield);
+    } else {
+        auto chain =
+            physics_system->collisionSystem().createCollider<ChainCollider2d>();
+        chain->setVertices(vertices);
+        chain->setThickness(0.5f);
+        terrain = std::move(chain);
+    }
+    return dropBallsOnGround(*physics_system, *terrain);
+}
+
+TEST(PhysicsSystem2dTest, HeightfieldStopsBalls) {
+    // the terrain top is at y = 10 + 2 sin(0.1 x) - 0.5 (y points down)
+    for (bool use_heightfield : {true, false}) {
+        for (const glm::vec2 &p : dropBallsOnTerrain(use_heightfield)) {
+            EXPECT_LT(p.y, 9.5f + 2.0f * std::sin(p.x * 0.1f));
+        }
+    }
+}
+
+TEST(PhysicsSystem2dTest, IntegrationSkipsStaticObjects) {
+    auto physics_system = PhysicsSystem2d::create(64, 2, BroadPhaseType::GRID);
+    physics_system->setGravity({0, 100.0f});
+
+    // more objects than one block of simd lanes, some static, one removed
+    std::vector<std::unique_ptr<PhysicsObject2d>> objects;
+    for (int i = 0; i < 11; i++) {
+        objects.push_back(physics_system->createPhysicsObject());
+        objects.back()->setPosition({float(i), 0.0f});
+        objects.back()->setMass(i % 3 == 0 ? 0.0f : float(i));
+    }
+    physics_system->destroyPhysicsObject(objects[4]);
+    objects.erase(objects.begin() + 4);
+
+    // reference free fall, two iterations per update
+    float y = 0.0f;
+    float prev_y = 0.0f;
+    for (int frame = 0; frame < 10; frame++) {
+        physics_system->update(0.02f);
+        for (int i = 0; i < 2; i++) {
+            const float new_y = (y + (y - prev_y)) + 100.0f * 0.01f * 0.01f;
+            prev_y = y;
+            y = new_y;
+        }
+    }
+
+    for (const auto &object : objects) {
+        const glm::vec2 p = object->position();
+        EXPECT_FLOAT_EQ(p.y, object->mass() > 0 ? y : 0.0f);
+        EXPECT_FLOAT_EQ(p.x, float(int(p.x)));
+    }
+}
+
+/// @brief Drop sticks (line colliders with a physics object at each end)
+/// and balls onto a floor and return the final object positions.
+static std::vector<glm::vec2> dropSticksAndBalls(size_t num_threads) {
+    auto physics_system = PhysicsSystem2d::create(
+        256, 2, BroadPhaseType::GRID, {.grid_size = 8.0f}, num_threads);
+    physics_system->setGravity({0, 100.0f});
+
+    auto floor =
+        physics_system->collisionSystem().createCollider<LineCollider2d>();
+    floor->setLine({{{-100.0f, 40.0f}, {100.0f, 40.0f}}, 1.0f});
+
+    std::vector<std::unique_ptr<PhysicsObject2d>> objects;
+    std::vector<std::unique_ptr<Collider2d>>      colliders;
+    for (int i = 0; i < 30; i++) {
+        const glm::vec2 p = {-60.0f + i * 4.0f, -float(i % 5) * 3.0f};
+        auto            stick = physics_system->collisionSystem()
+                         .createCollider<LineCollider2d>();
+        stick->setLine({{p, p + glm::vec2(2.0f, 1.0f)}, 0.5f});
+        for (int vertex = 0; vertex < 2; vertex++) {
+            objects.push_back(physics_system->createPhysicsObject());
+            objects.back()->setPosition(vertex == 0 ? p
+                                                    : p + glm::vec2(2.0f, 1.0f));
+            objects.back()->setCollider(*stick, vertex);
+        }
+        colliders.push_back(std::move(stick));
+
+        auto ball = physics_system->collisionSystem()
+                        .createCollider<CircleCollider2d>();
+        ball->setRadius(1.0f);
+        objects.push_back(physics_system->createPhysicsObject());
+        objects.back()->setPosition(p - glm::vec2(0.0f, 10.0f));
+        objects.back()->setCollider(*ball, 0);
+        colliders.push_back(std::move(ball));
+    }
+
+    for (int frame = 0; frame < 100; frame++) {
+        physics_system->update(0.01f);
+    }
+    std::vector<glm::vec2> positions;
+    for (const auto &object : objects) {
+        positions.push_back(object->position());
+    }
+    return positions;
+}
+
+TEST(PhysicsSystem2dTest, MultiThreadedIntegrationIsDeterministic) {
+    const std::vector<glm::vec2> positions = dropSticksAndBalls(1);
+    EXPECT_EQ(dropSticksAndBalls(2), positions);
+    EXPECT_EQ(dropSticksAndBalls(5), positions);
+}
+
+/// @brief How far a stack of balls sank
+struct StackSink {
+    /// @brief how far the bottom ball sank into the floor
+    float bottom = 0.0f;
+    /// @brief how far the top ball sank, i.e., the bottom sink plus how much
+    /// the stack compressed
+    float top = 0.0f;
+};
+
+/// @brief Stack a column of balls on a floor and return how far it sank
+static StackSink stackBalls(int iterations, bool sub_stepping,
+                        const contact_solver_config_t &solver_config = {}) {
+    auto physics_system = PhysicsSystem2d::create(64, iterations,
+                                                  BroadPhaseType::GRID,
+                                                  {.grid_size = 8.0f});
+    physics_system->setGravity({0, 100.0f});
+    physics_system->setSubStepping(sub_stepping);
+    physics_system->setContactSolverConfig(solver_config);
+
+    // the floor top is at y = 10
+    auto floor =
+        physics_system->collisionSystem().createCollider<LineCollider2d>();
+    floor->setLine({{{-100.0f, 10.5f}, {100.0f, 10.5f}}, 0.5f});
+
+    std::vector<std::unique_ptr<PhysicsObject2d>>  balls;
+    std::vector<std::unique_ptr<CircleCollider2d>> colliders;
+    for (int i = 0; i < 8; i++) {
+        auto ball = physics_system->createPhysicsObject();
+        ball->setPosition({0.0f, 9.0f - 2.0f * float(i)});
+        auto collider = physics_system->collisionSystem()
+                            .createCollider<CircleCollider2d>();
+        collider->setRadius(1.0f);
+        collider->setRestitution(0.0f);
+        ball->setCollider(*collider, 0);
+        balls.push_back(std::move(ball));
+        colliders.push_back(std::move(collider));
+    }
+
+    for (int frame = 0; frame < 120; frame++) {
+        physics_system->update(1.0f / 60.0f);
+    }
+    return {balls.front()->position().y + 1.0f - 10.0f,
+            balls.back()->position().y -
+                (9.0f - 2.0f * float(balls.size() - 1))};
+}
+
+TEST(PhysicsSystem2dTest, SubSteppingStacksBalls) {
+    // two sub-steps sink less than two plain iterations, and more sub-steps
+    // sink less again
+    const float sub_stepped = stackBalls(2, true).bottom;
+    EXPECT_LT(sub_stepped, 0.5f * stackBalls(2, false).bottom);
+    EXPECT_LT(stackBalls(4, true).bottom, sub_stepped);
+}
+
+TEST(PhysicsSystem2dTest, SubSteppingMatchesMoreIterations) {
+    // two sub-steps sink about as little into the floor as eight plain
+    // iterations, and the stack compresses less
+    const StackSink sub_stepped = stackBalls(2, true);
+    const StackSink iterated = stackBalls(8, false);
+    EXPECT_LT(sub_stepped.bottom, 1.5f * iterated.bottom);
+    EXPECT_LT(sub_stepped.top, iterated.top);
+}
+
+TEST(PhysicsSystem2dTest, SubSteppingReusesInflatedBroadPhase) {
+    // the ball only reaches the floor in the last sub-step, the broad phase
+    // of the first sub-step must already have paired them
+    broad_phase_config_t config;
+    config.swept_aabb_threshold = -1.0f;
+    auto physics_system =
+        PhysicsSystem2d::create(16, 4, BroadPhaseType::GRID, config);
+    physics_system->setSubStepping(true);
+
+    // floor at y = 10
+    auto floor =
+        physics_system->collisionSystem().createCollider<LineCollider2d>();
+    floor->setLine({{{-100.0f, 10.0f}, {100.0f, 10.0f}}, 0.1f});
+
+    auto ball = physics_system->createPhysicsObject();
+    ball->setPosition({0.0f, 6.0f});
+    auto collider =
+        physics_system->collisionSystem().createCollider<CircleCollider2d>();
+    collider->setRadius(1.0f);
+    ball->setCollider(*collider, 0);
+    ball->setVelocity({0.0f, 75.0f}); // 1.25 per sub-step
+
+    for (int frame = 0; frame < 30; frame++) {
+        physics_system->update(1.0f / 60.0f);
+    }
+    EXPECT_LT(ball->position().y, 10.0f);
+}
+
+TEST(PhysicsSystem2dTest, SolverIterationsStackBalls) {
+    // the single impulse per contact lets the stack sink and compress
+    const StackSink single = stackBalls(1, false);
+    EXPECT_GT(single.bottom, 0.5f);
+    EXPECT_GT(single.top, 5.0f);
+
+    // velocity iterations with warm starting and position iterations hold it
+    const StackSink iterated = stackBalls(
+        1, false, {.velocity_iterations = 8, .position_iterations = 2});
+    EXPECT_LT(std::abs(iterated.bottom), 0.05f);
+    EXPECT_LT(std::abs(iterated.top), 0.25f);
+
+    // more position iterations recover more of the penetration without
+    // warm starting
+    const contact_solver_config_t cold = {.velocity_iterations = 8,
+                                          .warm_starting = 0.0f};
+    contact_solver_config_t cold_positions = cold;
+    cold_positions.position_iterations = 8;
+    EXPECT_LT(stackBalls(1, false, cold_positions).top,
+              stackBalls(1, false, cold).top);
+}
+
+TEST(PhysicsSystem2dTest, ContactSolverConfigIsValidated) {
+    auto physics_system = PhysicsSystem2d::create(64, 1);
+    EXPECT_THROW(physics_system->setContactSolverConfig(
+                     {.velocity_iterations = 0}),
+                 std::runtime_error);
+    EXPECT_THROW(physics_system->setContactSolverConfig(
+                     {.position_iterations = -1}),
+                 std::runtime_error);
+}